@@ -1,15 +1,20 @@
 #include <climits>
 #include <cstdlib>
+#include <cstring>
 #include <cwchar>
 #include <fcntl.h>
+#include <fstream>
 #include <iostream>
+#include <stdexcept>
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <unistd.h>
+#include <vector>
 
 #include "Parser.h"
 #include "boost/iostreams/device/file_descriptor.hpp"
 #include "boost/iostreams/stream.hpp"
+#include "cache.h"
 #include "config.h"
 #include "help.h"
 
@@ -23,11 +28,15 @@ constexpr const char *run_head = "%%------------------------------------RUN-----
 constexpr const char *aut_head = "%%---------------------------------AUTOMATON----------------------------------\n";
 
 static Rabin_automaton *parse();
+static int check(const Rabin_automaton &, const char *);
 static int out_fd(const char *, const bool);
 
 int
 main(int argc, char *argv[])
 {
+	// a SIGUSR1 received while parsing waits for the progress reporter
+	// instead of terminating the process
+	block_progress_signal(nullptr);
 	for (int i = 0; i < argc; i++) {
 		if (nullptr == argv[i]) {
 			std::cout << usage;
@@ -36,7 +45,7 @@ main(int argc, char *argv[])
 	}
 	{
 		int op = 0;
-		while ((op = getopt(argc, argv, "i:o:L:t:wglhV")) != -1) {
+		while ((op = getopt(argc, argv, "i:o:L:t:T:c:d:e:k:m:p:r:C:B:E:K:S:wglsvaDhV")) != -1) {
 			switch (op) {
 				case 'i':
 					config.in = optarg;
@@ -60,6 +69,109 @@ main(int argc, char *argv[])
 						config.max_threads = static_cast<int>(tmp);
 					}
 					break;
+				case 'T':
+					config.trace_out = optarg;
+					break;
+				case 'c':
+					config.checks = 0;
+					for (const char *c = optarg; '\0' != *c; c++) {
+						switch (*c) {
+							case 'p':
+								config.checks |= 1 << CHECK_PRODUCTIVE;
+								break;
+							case 'c':
+								config.checks |= 1 << CHECK_CYCLES;
+								break;
+							case 'a':
+								config.checks |= 1 << CHECK_PRUNING;
+								break;
+							case 's':
+								config.checks |= CHECK_SHORTCUTS;
+								break;
+							case '-':
+								break;
+							default:
+								std::cout << usage;
+								return EXIT_FAILURE;
+						}
+					}
+					break;
+				case 'd':
+					config.spill_dir = optarg;
+					break;
+				case 'e':
+					config.certificate_out = optarg;
+					break;
+				case 'k':
+					config.checkpoint = optarg;
+					break;
+				case 'm':
+					errno = 0;
+					{
+						unsigned long tmp = strtoul(optarg, nullptr, 10);
+						if (errno || (SIZE_MAX >> 20) < tmp || 1 > tmp) {
+							std::cout << usage;
+							return EXIT_FAILURE;
+						}
+						config.spill_target = static_cast<std::size_t>(tmp) << 20;
+					}
+					break;
+				case 'p':
+					errno = 0;
+					{
+						unsigned long tmp = strtoul(optarg, nullptr, 10);
+						if (errno || UINT_MAX < tmp || 1 > tmp) {
+							std::cout << usage;
+							return EXIT_FAILURE;
+						}
+						config.progress = static_cast<unsigned int>(tmp);
+					}
+					break;
+				case 'r':
+					config.resume = optarg;
+					break;
+				case 'C':
+					config.cache_dir = optarg;
+					break;
+				case 'E':
+					config.certificate_in = optarg;
+					break;
+				case 'B':
+					errno = 0;
+					{
+						unsigned long tmp = strtoul(optarg, nullptr, 10);
+						if (errno || (SIZE_MAX >> 20) < tmp || 1 > tmp) {
+							std::cout << usage;
+							return EXIT_FAILURE;
+						}
+						config.cache_bound = static_cast<std::size_t>(tmp) << 20;
+					}
+					break;
+				case 'K':
+					errno = 0;
+					{
+						char *end = nullptr;
+						unsigned long tmp = strtoul(optarg, &end, 10);
+						if (errno || UINT_MAX < tmp || 1 > tmp || ('\0' != *end && 0 != strcmp(end, "s"))) {
+							std::cout << usage;
+							return EXIT_FAILURE;
+						}
+						config.checkpoint_heights = ('\0' == *end) ? static_cast<unsigned int>(tmp) : 0;
+						config.checkpoint_seconds = ('\0' == *end) ? 0 : static_cast<unsigned int>(tmp);
+					}
+					break;
+				case 'S':
+					errno = 0;
+					{
+						char *end = nullptr;
+						unsigned long tmp = strtoul(optarg, &end, 10);
+						if (errno || STATE_MAX <= tmp || '\0' != *end) {
+							std::cout << usage;
+							return EXIT_FAILURE;
+						}
+						config.symmetry_bound = static_cast<state_t>(tmp);
+					}
+					break;
 				case 'w':
 					config.overwrite = true;
 					break;
@@ -69,6 +181,18 @@ main(int argc, char *argv[])
 				case 'l':
 					config.lp = true;
 					break;
+				case 's':
+					config.stats = true;
+					break;
+				case 'v':
+					config.verify = true;
+					break;
+				case 'a':
+					config.all_states = true;
+					break;
+				case 'D':
+					config.deterministic = true;
+					break;
 				case 'h':
 					config.help = true;
 					break;
@@ -92,10 +216,39 @@ main(int argc, char *argv[])
 	if (optind < argc) {
 		config.in = argv[optind];
 	}
-	const Rabin_automaton *const automaton = parse();
+	if (0 < config.spill_target && !Spill_store::configure(config.spill_target, config.spill_dir)) {
+		std::cerr << "could not create a spill file in " << config.spill_dir << ": " << strerror(errno) << std::endl;
+		return EXIT_FAILURE;
+	}
+	// the cache only keeps the runs of the starting states, and is not used
+	// to check a certificate; its results are kept apart by the checks, since
+	// the search without the shortcuts may reject runs they accept
+	const Run_cache *const cache
+		= (nullptr != config.cache_dir && !config.all_states && nullptr == config.certificate_in)
+			  ? new Run_cache(config.cache_dir, config.cache_bound, config.checks)
+			  : nullptr;
+	if (nullptr != cache && !cache->open()) {
+		std::cerr << "could not create the cache directory " << config.cache_dir << ": " << strerror(errno)
+				  << std::endl;
+		return EXIT_FAILURE;
+	}
+	Rabin_automaton *const automaton = parse();
 	if (nullptr == automaton) {
+		delete cache;
 		return EXIT_FAILURE;
 	}
+	if (nullptr != config.certificate_in) {
+		const int status = check(*automaton, config.certificate_in);
+		delete automaton;
+		delete cache;
+		return status;
+	}
+	automaton->set_checks(config.checks);
+	automaton->set_deterministic(config.deterministic);
+	automaton->set_symmetry_bound(config.symmetry_bound);
+	automaton->set_all_states(config.all_states);
+	automaton->set_checkpoint(config.checkpoint, config.checkpoint_heights, config.checkpoint_seconds);
+	automaton->set_resume(config.resume);
 	ios::stream<ios::file_descriptor> os;
 	if (config.lp) {
 		const int fd = out_fd(config.lp_out, config.overwrite);
@@ -107,31 +260,112 @@ main(int argc, char *argv[])
 		}
 	}
 	std::cout << "Searching for an accepted regular run..." << std::endl;
-	const Run *run = nullptr;
-	if (nullptr != (run = automaton->find_run(config.max_threads))) {
+	Run *run = nullptr;
+	Search_stats stats;
+	Trace *const trace = (nullptr != config.trace_out) ? new Trace : nullptr;
+	stats.cached = nullptr != cache && cache->find(*automaton, run);
+	if (!stats.cached) {
+		Search_progress progress;
+		try {
+			const Progress_reporter reporter(progress, config.progress);
+			run = automaton->find_run(config.max_threads, config.stats ? &stats : nullptr, trace, &progress);
+		} catch (const std::runtime_error &e) {
+			std::cerr << e.what() << std::endl;
+			delete trace;
+			delete automaton;
+			delete cache;
+			return EXIT_FAILURE;
+		}
+		if (nullptr != cache && !cache->store(*automaton, run)) {
+			std::cerr << "could not store the result in the cache directory " << config.cache_dir << ": "
+					  << strerror(errno) << std::endl;
+		}
+	}
+	if (config.stats) {
+		std::cerr << stats;
+	}
+	if (nullptr != trace) {
+		const int fd = out_fd(config.trace_out, config.overwrite);
+		if (-1 < fd) {
+			ios::stream<ios::file_descriptor> ts(ios::file_descriptor(fd, ios::close_handle));
+			ts << *trace << std::endl;
+		}
+		delete trace;
+	}
+	if (config.verify && nullptr != run && !automaton->verify(*run)) {
+		std::cerr << "the run found is not an accepted run of the automaton" << std::endl;
+		delete run;
+		delete automaton;
+		delete cache;
+		return EXIT_FAILURE;
+	}
+	// with -a the run may only cover other states than the starting one
+	std::vector<state_t> nonempty;
+	for (state_t q = 0; nullptr != run && q < automaton->states; q++) {
+		if (run->nonempty(q)) {
+			nonempty.push_back(q);
+		}
+	}
+	if (nullptr != run && run->nonempty(automaton->get_start())) {
 		std::cout << "NONEMPTY LANGUAGE" << std::endl;
 		if (os.is_open()) {
 			os << std::endl << run_head;
 			run->print_logic_prog_rep(os);
 			os << std::endl;
-			os.close();
-		}
-		if (config.graphviz) {
-			const int fd = out_fd(config.graphviz_out, config.overwrite);
-			if (-1 < fd) {
-				os.open(ios::file_descriptor(fd, ios::close_handle));
-				os << *run << std::endl;
-				os.close();
-			}
 		}
-		delete run;
 	} else {
 		std::cout << "EMPTY LANGUAGE" << std::endl;
-		if (os.is_open()) {
+	}
+	if (os.is_open()) {
+		os.close();
+	}
+	if (config.all_states) {
+		std::cout << "nonempty states:";
+		for (auto q = nonempty.cbegin(); q != nonempty.cend(); q++) {
+			std::cout << ' ' << *q;
+		}
+		std::cout << std::endl;
+	}
+	if (nullptr != config.certificate_out && (nullptr == run || !run->nonempty(automaton->get_start()))) {
+		Certificate *const certificate = automaton->find_certificate();
+		const char *error = nullptr;
+		if (nullptr == certificate) {
+			error = "the emptiness game of the automaton does not confirm the empty language, no certificate written";
+		} else if (config.verify && !automaton->check_certificate(*certificate)) {
+			error = "the certificate found is not an emptiness certificate of the automaton";
+		}
+		if (nullptr != error) {
+			std::cerr << error << std::endl;
+			delete certificate;
+			delete run;
+			delete automaton;
+			delete cache;
+			return EXIT_FAILURE;
+		}
+		const int fd = out_fd(config.certificate_out, config.overwrite);
+		if (-1 < fd) {
+			os.open(ios::file_descriptor(fd, ios::close_handle));
+			certificate->serialize(os);
 			os.close();
 		}
+		delete certificate;
 	}
+	if (nullptr != run && config.graphviz) {
+		const int fd = out_fd(config.graphviz_out, config.overwrite);
+		if (-1 < fd) {
+			os.open(ios::file_descriptor(fd, ios::close_handle));
+			if (config.all_states) {
+				run->print_roots(os, nonempty);
+			} else {
+				os << *run;
+			}
+			os << std::endl;
+			os.close();
+		}
+	}
+	delete run;
 	delete automaton;
+	delete cache;
 	return EXIT_SUCCESS;
 }
 
@@ -157,6 +391,26 @@ parse()
 	return res;
 }
 
+// checks the emptiness certificate in the file path instead of searching
+static int
+check(const Rabin_automaton &automaton, const char *path)
+{
+	std::ifstream is(path);
+	if (!is) {
+		std::cerr << "could not open file " << path << ": " << strerror(errno) << std::endl;
+		return EXIT_FAILURE;
+	}
+	Certificate *const certificate = Certificate::deserialize(is);
+	const bool valid = nullptr != certificate && automaton.check_certificate(*certificate);
+	delete certificate;
+	if (!valid) {
+		std::cerr << "the certificate is not an emptiness certificate of the automaton" << std::endl;
+		return EXIT_FAILURE;
+	}
+	std::cout << "EMPTY LANGUAGE" << std::endl;
+	return EXIT_SUCCESS;
+}
+
 static int
 out_fd(const char *path, const bool overwrite)
 {
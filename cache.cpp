@@ -0,0 +1,136 @@
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <dirent.h>
+#include <fcntl.h>
+#include <fstream>
+#include <sstream>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+#include <vector>
+
+#include "cache.h"
+
+static const std::string suffix = ".run";
+
+std::string
+Run_cache::key(const Rabin_automaton &a) const
+{
+	std::ostringstream os;
+	os << "checks " << checks << std::endl;
+	a.print_canonical_rep(os);
+	return os.str();
+}
+
+bool
+Run_cache::open() const
+{
+	return 0 == mkdir(dir.c_str(), 0775) || EEXIST == errno;
+}
+
+// FNV-1a of the key
+std::string
+Run_cache::path(const std::string &rep) const
+{
+	uint_least64_t h = 14695981039346656037u;
+	for (auto c = rep.cbegin(); c != rep.cend(); c++) {
+		h = ((h ^ static_cast<unsigned char>(*c)) * 1099511628211u) & UINT64_C(0xffffffffffffffff);
+	}
+	char name[17];
+	snprintf(name, sizeof(name), "%016" PRIxLEAST64, h);
+	return dir + '/' + name + suffix;
+}
+
+bool
+Run_cache::find(const Rabin_automaton &a, Run *&run) const
+{
+	const std::string rep = key(a);
+	const std::string p = path(rep);
+	std::ifstream is(p);
+	if (!is) {
+		return false;
+	}
+	std::string stored(rep.size(), '\0');
+	std::string verdict;
+	if (!is.read(&stored[0], stored.size()) || stored != rep || !(is >> verdict)) {
+		return false;
+	}
+	if ("empty" == verdict) {
+		run = nullptr;
+	} else if ("nonempty" != verdict || nullptr == (run = Run::deserialize(is, a.states, a.get_start()))) {
+		return false;
+	}
+	// the modification time orders the files for the eviction
+	utimensat(AT_FDCWD, p.c_str(), nullptr, 0);
+	return true;
+}
+
+// the file is written aside and renamed, so that concurrent processes sharing
+// the directory never read it partially written
+bool
+Run_cache::store(const Rabin_automaton &a, const Run *const run) const
+{
+	const std::string rep = key(a);
+	const std::string p = path(rep);
+	const std::string tmp = p + '.' + std::to_string(getpid());
+	{
+		std::ofstream os(tmp);
+		os << rep << ((nullptr != run) ? "nonempty" : "empty") << std::endl;
+		if (nullptr != run) {
+			run->serialize(os);
+		}
+		os.close();
+		if (!os) {
+			const int e = errno;
+			unlink(tmp.c_str());
+			errno = e;
+			return false;
+		}
+	}
+	if (0 != rename(tmp.c_str(), p.c_str())) {
+		const int e = errno;
+		unlink(tmp.c_str());
+		errno = e;
+		return false;
+	}
+	evict();
+	return true;
+}
+
+// removes the least recently used files until the directory is within bound
+void
+Run_cache::evict() const
+{
+	DIR *const d = opendir(dir.c_str());
+	if (nullptr == d) {
+		return;
+	}
+	struct Entry
+	{
+		std::string path;
+		struct timespec used;
+		off_t size;
+	};
+	std::vector<Entry> entries;
+	std::size_t total = 0;
+	for (const struct dirent *e = readdir(d); nullptr != e; e = readdir(d)) {
+		const std::string name = e->d_name;
+		struct stat st;
+		if (name.size() <= suffix.size() || 0 != name.compare(name.size() - suffix.size(), suffix.size(), suffix)
+			|| 0 != stat((dir + '/' + name).c_str(), &st)) {
+			continue;
+		}
+		entries.push_back({dir + '/' + name, st.st_mtim, st.st_size});
+		total += st.st_size;
+	}
+	closedir(d);
+	std::sort(entries.begin(), entries.end(), [](const Entry &x, const Entry &y) {
+		return x.used.tv_sec < y.used.tv_sec || (x.used.tv_sec == y.used.tv_sec && x.used.tv_nsec < y.used.tv_nsec);
+	});
+	for (auto e = entries.cbegin(); e != entries.cend() && max_bytes < total; e++) {
+		if (0 == unlink(e->path.c_str())) {
+			total -= e->size;
+		}
+	}
+}
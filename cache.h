@@ -0,0 +1,37 @@
+#ifndef CACHE_H
+#define CACHE_H
+
+#include <cstddef>
+#include <string>
+
+#include "rabin_automaton.h"
+
+// directory of the verdicts and runs of the automata already searched, a file
+// per automaton named after the hash of its canonical representation and of
+// the checks of the search, that can change the verdict, both also stored in
+// the file to tell apart the automata with the same hash; the least recently
+// used files are removed when the directory exceeds its bound
+class Run_cache final
+{
+	const std::string dir;
+	const std::size_t max_bytes;
+	const unsigned int checks;
+
+public:
+	Run_cache(const char *const d, const std::size_t max, const unsigned int c) : dir{d}, max_bytes{max}, checks{c} {};
+
+	// on failure returns false with errno set
+	bool open() const;
+	// returns true on a hit, with run set to the found run or to nullptr if
+	// the language of the automaton is empty
+	bool find(const Rabin_automaton &, Run *&run) const;
+	// on failure returns false with errno set
+	bool store(const Rabin_automaton &, const Run *const) const;
+
+private:
+	std::string key(const Rabin_automaton &) const;
+	std::string path(const std::string &) const;
+	void evict() const;
+};
+
+#endif
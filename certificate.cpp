@@ -0,0 +1,49 @@
+#include <string>
+
+#include "certificate.h"
+
+// the number of nodes and then a line per node with its state, its number of
+// entries and the nodes of the entries
+std::ostream &
+Certificate::serialize(std::ostream &os) const
+{
+	os << "nodes " << nodes() << std::endl;
+	for (std::size_t x = 0; x < nodes(); x++) {
+		os << state[x] << ' ' << degree(x);
+		for (std::size_t i = 0; i < degree(x); i++) {
+			os << ' ' << next(x, i);
+		}
+		os << std::endl;
+	}
+	return os;
+}
+
+Certificate *
+Certificate::deserialize(std::istream &is)
+{
+	std::string word;
+	std::size_t n = 0;
+	if (!(is >> word >> n) || "nodes" != word) {
+		return nullptr;
+	}
+	Certificate *const res = new Certificate;
+	for (std::size_t x = 0; x < n; x++) {
+		state_t q = 0;
+		std::size_t k = 0;
+		if (!(is >> q >> k)) {
+			delete res;
+			return nullptr;
+		}
+		res->state.push_back(q);
+		for (std::size_t i = 0; i < k; i++) {
+			std::size_t y = 0;
+			if (!(is >> y) || n <= y) {
+				delete res;
+				return nullptr;
+			}
+			res->child.push_back(y);
+		}
+		res->first.push_back(res->child.size());
+	}
+	return res;
+}
@@ -0,0 +1,35 @@
+#ifndef CERTIFICATE_H
+#define CERTIFICATE_H
+
+#include <cstddef>
+#include <istream>
+#include <ostream>
+#include <vector>
+
+#include "typedefs.h"
+
+// a strategy of the path against every run, as a graph whose nodes are
+// labelled by states: a node has an entry for each transition of its state,
+// in the order of the transitions of the automaton, with the node of the
+// child the path follows; the language is empty when a node of the starting
+// state has such entries and no path of the graph is accepted
+class Certificate final
+{
+public:
+	std::vector<state_t> state;
+	// the entries of node x are the children first[x] up to first[x + 1]
+	std::vector<std::size_t> first;
+	std::vector<std::size_t> child;
+
+	Certificate() : first(1, 0) {};
+
+	std::size_t nodes() const { return state.size(); };
+	std::size_t degree(const std::size_t x) const { return first[x + 1] - first[x]; };
+	std::size_t next(const std::size_t x, const std::size_t i) const { return child[first[x] + i]; };
+
+	std::ostream &serialize(std::ostream &) const;
+	// returns nullptr if the input is malformed
+	static Certificate *deserialize(std::istream &);
+};
+
+#endif
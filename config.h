@@ -1,19 +1,45 @@
 #ifndef CONFIG_H
 #define CONFIG_H
 
+#include <cstddef>
+
+#include "search_stats.h"
+#include "symmetry.h"
+
 struct Config
 {
 	const char *in;
 	const char *graphviz_out;
 	const char *lp_out;
+	const char *trace_out;
+	const char *spill_dir;
+	const char *cache_dir;
+	const char *checkpoint;
+	const char *resume;
+	const char *certificate_out;
+	const char *certificate_in;
 	bool overwrite;
 	bool graphviz;
 	bool lp;
+	bool stats;
+	bool deterministic;
+	bool verify;
+	bool all_states;
 	bool help;
 	bool version;
 	int max_threads;
+	std::size_t spill_target;
+	std::size_t cache_bound;
+	state_t symmetry_bound;
+	unsigned int checks;
+	unsigned int progress;
+	unsigned int checkpoint_heights;
+	unsigned int checkpoint_seconds;
 };
 
-static struct Config config = {nullptr, "run.gv", "automaton.lp", false, false, false, false, false, 1};
+static struct Config config
+	= {nullptr, "run.gv", "automaton.lp", nullptr, ".", nullptr, nullptr, nullptr, nullptr, nullptr, false, false,
+	   false, false, false, false, false, false, false, 1, 0, std::size_t{64} << 20, SYMMETRY_BOUND, ALL_CHECKS, 0, 1,
+	   0};
 
 #endif
@@ -14,6 +14,26 @@ R"(
 
 options:
 
+  -a  : Print all the states from which the automaton has an accepted run,
+        searching to completion instead of stopping at the starting state;
+        the run of the -g option then has a root for each of them, the -v
+        option checks them all and the -C option is ignored
+
+  -c <checks> : Run before the search only the quick emptiness checks named
+                by the letters of <checks>: p (productive states), c (cycles
+                through an acceptance condition), a (pruning of the states
+                reaching no such cycle), s (parity game, runs in a single
+                acceptance condition and quotient of Rabin pairs), or - for
+                none (default: pcas)
+
+  -d <dir>  : Set <dir> as the directory of the spill files of the -m option
+              (default: the current directory)
+
+  -e <file> : When the language is empty, write to <file> a certificate of
+              its emptiness, the strategy of the paths against every run
+              given by an emptiness game, to be checked with the -E option
+              (checked before being written with the -v option)
+
   -g  : Possibly output a Graphviz representation of a found successful run
         to a file (default file: run.gv)
 
@@ -21,20 +41,69 @@ options:
 
   -i <file> : Set <file> as the input file
 
+  -k <file> : Save the state of the search to the checkpoint file <file> at
+              the end of its heights, as often as set by the -K option,
+              to resume it with the -r option
+
   -l  : Output a logic programming representation of the automaton and possibly
         of a found successful run to a file (default file: automaton.lp)
 
+  -m <MiB>  : Place the search data in memory mapped files and keep in
+              memory only about the last <MiB> (>= 1) mebibytes of it, the
+              older heights being written back to disk
+
   -o <file> : Set <file> as the output file for the -g option and also
               implicitly activate option -g
 
+  -p <sec>  : Print the progress of the search (height, pieces, nonempty
+              states and generation rate) to the standard error every <sec>
+              (>= 1) seconds, besides whenever SIGUSR1 is received
+
+  -r <file> : Resume the search from the checkpoint file <file> of the -k
+              option, written for the same automaton and -S option
+
+  -s  : Print statistics about the search (per height piece counts, phase
+        times and memory usage) to the standard error
+
   -t <num>  : Set <num> (>= 1) as the maximun number of concurrent threads
               (default: 1)
 
+  -v  : Check that a found successful run is a run of the automaton whose
+        paths are all accepted, and exit with a failure otherwise
+
   -w  : Overwite the content of output files that already exist
 
+  -B <MiB>  : Set <MiB> (>= 1) as the bound in mebibytes of the size of the
+              cache directory of the -C option, beyond which the least
+              recently used results are removed (default: 64)
+
+  -C <dir>  : Look up the result in the cache directory <dir> before
+              searching and store it there afterwards, automata differing
+              only in the order or the repetition of their transitions and
+              acceptance conditions share their result
+
+  -D  : Find the same run whatever the number of threads of the -t option,
+        by saving the runs found at each height in order of state
+
+  -E <file> : Instead of searching, check in about linear time that <file>
+              is a certificate of the -e option proving that the language is
+              empty, and exit with a failure otherwise
+
+  -K <num>[s] : Write the checkpoints of the -k option every <num> (>= 1)
+                heights, or every <num> seconds with the s suffix
+                (default: 1)
+
   -L <file> : Set <file> as the output file for the -l option and also
               implicitly activate option -l
 
+  -S <num>  : Look for the permutations of the states mapping the automaton
+              onto itself only if it has at most <num> states, 0 for never
+              (default: 2048)
+
+  -T <file> : Write a Chrome trace event representation of the scheduling of
+              the search to <file> (viewable with chrome://tracing or
+              Perfetto)
+
   -V : Print version information and exit
 
 Get help/Report bugs/Provide suggestions at: https://github.com/max-co/bracket
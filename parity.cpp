@@ -0,0 +1,547 @@
+#include <algorithm>
+#include <climits>
+#include <functional>
+#include <map>
+#include <set>
+#include <stdexcept>
+#include <vector>
+
+#include "rabin_automaton.h"
+
+namespace
+{
+constexpr std::size_t NO_MOVE = SIZE_MAX;
+
+typedef std::function<unsigned int(const state_t, std::vector<state_t> &)> Record_read;
+
+// the emptiness game of an automaton with a parity condition: on the node of
+// a state player 0 picks one of its transitions, on the node of a transition
+// player 1 picks one of its children; a transition has the priority of its
+// state and player 0 wins the plays whose lowest priority seen infinitely
+// often is even
+class Parity_game final
+{
+	const state_t states;
+	std::vector<unsigned int> priority;
+	std::vector<std::vector<std::size_t>> succ;
+	std::vector<std::vector<std::size_t>> pred;
+
+public:
+	std::vector<const Out_transition *> transition;
+	// the move of player 0 on the nodes of the states it wins and of player 1
+	// on the nodes of the transitions it wins
+	std::vector<std::size_t> strategy;
+
+	Parity_game(
+		const state_t n,
+		const std::vector<unsigned int> &priorities,
+		const std::list<Out_transition> *const transitions)
+		: states{n}, priority(priorities), succ(n), transition(n, nullptr)
+	{
+		for (state_t q = 0; q < n; q++) {
+			for (auto t = transitions[q].cbegin(); t != transitions[q].cend(); t++) {
+				succ[q].push_back(succ.size());
+				succ.push_back({t->left, t->right});
+				priority.push_back(priority[q]);
+				transition.push_back(&*t);
+			}
+		}
+		pred.resize(succ.size());
+		for (std::size_t v = 0; v < succ.size(); v++) {
+			for (auto w = succ[v].cbegin(); w != succ[v].cend(); w++) {
+				pred[*w].push_back(v);
+			}
+		}
+		strategy.assign(succ.size(), NO_MOVE);
+	};
+
+	const std::vector<std::size_t> &moves(const std::size_t v) const { return succ[v]; };
+
+	// the nodes won by player 0, player 1 wins the states without transitions
+	// and the nodes it can force there
+	std::vector<std::size_t> solve()
+	{
+		std::vector<char> game(succ.size(), 1);
+		std::vector<char> in(succ.size(), 0);
+		std::vector<std::size_t> lost;
+		for (state_t q = 0; q < states; q++) {
+			if (succ[q].empty()) {
+				in[q] = 1;
+				lost.push_back(q);
+			}
+		}
+		attract(game, 1, lost, in);
+		std::vector<std::size_t> nodes;
+		for (std::size_t v = 0; v < succ.size(); v++) {
+			if (!in[v]) {
+				nodes.push_back(v);
+			}
+		}
+		return solve(std::move(nodes));
+	};
+
+private:
+	int owner(const std::size_t v) const { return (v < states) ? 0 : 1; };
+
+	// extends set (marked by in) with the nodes of game from which player can
+	// force a play into it, setting the moves of player
+	void attract(const std::vector<char> &game, const int player, std::vector<std::size_t> &set, std::vector<char> &in)
+	{
+		std::vector<std::size_t> count(succ.size(), NO_MOVE);
+		for (std::size_t i = 0; i < set.size(); i++) {
+			const std::size_t v = set[i];
+			for (auto u = pred[v].cbegin(); u != pred[v].cend(); u++) {
+				if (!game[*u] || in[*u]) {
+					continue;
+				}
+				if (owner(*u) != player) {
+					if (NO_MOVE == count[*u]) {
+						count[*u] = 0;
+						for (auto w = succ[*u].cbegin(); w != succ[*u].cend(); w++) {
+							count[*u] += game[*w];
+						}
+					}
+					if (0 < --count[*u]) {
+						continue;
+					}
+				} else {
+					strategy[*u] = v;
+				}
+				in[*u] = 1;
+				set.push_back(*u);
+			}
+		}
+	};
+
+	// Zielonka's algorithm on the subgame of nodes, which has no dead ends:
+	// the player of the lowest priority p wins everything if its opponent
+	// wins nothing once the attractor of p is removed, otherwise the attractor
+	// of what the opponent wins there is won by the opponent and the rest is
+	// solved again; the recursion depth is bounded by the number of priorities
+	std::vector<std::size_t> solve(std::vector<std::size_t> nodes)
+	{
+		std::vector<std::size_t> won;
+		std::vector<char> game(succ.size(), 0);
+		std::vector<char> in(succ.size(), 0);
+		while (!nodes.empty()) {
+			unsigned int p = UINT_MAX;
+			for (auto v = nodes.cbegin(); v != nodes.cend(); v++) {
+				game[*v] = 1;
+				p = std::min(p, priority[*v]);
+			}
+			const int i = p % 2;
+			std::vector<std::size_t> a;
+			for (auto v = nodes.cbegin(); v != nodes.cend(); v++) {
+				if (priority[*v] != p) {
+					continue;
+				}
+				in[*v] = 1;
+				a.push_back(*v);
+				for (auto w = succ[*v].cbegin(); i == owner(*v) && w != succ[*v].cend(); w++) {
+					if (game[*w]) {
+						strategy[*v] = *w;
+						break;
+					}
+				}
+			}
+			attract(game, i, a, in);
+			std::vector<std::size_t> rest;
+			for (auto v = nodes.cbegin(); v != nodes.cend(); v++) {
+				if (!in[*v]) {
+					rest.push_back(*v);
+				}
+			}
+			// what the opponent of the player of p wins without its attractor
+			std::vector<std::size_t> lost = solve(rest);
+			for (auto v = a.cbegin(); v != a.cend(); v++) {
+				in[*v] = 0;
+			}
+			if (0 == i) {
+				for (auto v = lost.cbegin(); v != lost.cend(); v++) {
+					in[*v] = 1;
+				}
+				std::vector<std::size_t> other;
+				for (auto v = rest.cbegin(); v != rest.cend(); v++) {
+					if (!in[*v]) {
+						other.push_back(*v);
+					}
+				}
+				for (auto v = lost.cbegin(); v != lost.cend(); v++) {
+					in[*v] = 0;
+				}
+				lost = std::move(other);
+			}
+			if (lost.empty()) {
+				if (0 == i) {
+					won.insert(won.end(), nodes.cbegin(), nodes.cend());
+				}
+				break;
+			}
+			for (auto v = lost.cbegin(); v != lost.cend(); v++) {
+				in[*v] = 1;
+			}
+			attract(game, 1 - i, lost, in);
+			if (1 == i) {
+				won.insert(won.end(), lost.cbegin(), lost.cend());
+			}
+			std::vector<std::size_t> left;
+			for (auto v = nodes.cbegin(); v != nodes.cend(); v++) {
+				game[*v] = 0;
+				if (!in[*v]) {
+					left.push_back(*v);
+				}
+			}
+			for (auto v = lost.cbegin(); v != lost.cend(); v++) {
+				in[*v] = 0;
+			}
+			nodes = std::move(left);
+		}
+		return won;
+	};
+};
+
+// the product of an automaton with a record updated by every state read along
+// its paths, built only for the pairs of a state and a record reached from
+// the pairs of the starting states and the initial record, which are the
+// first pairs; read updates the record of a pair to the one of its children
+// and returns the priority of the pair
+class Record_product final
+{
+	typedef std::map<std::pair<state_t, std::vector<state_t>>, std::size_t> Id_map;
+
+	Id_map ids;
+	std::vector<Id_map::const_iterator> pairs;
+
+public:
+	std::vector<state_t> state;
+	std::vector<unsigned int> priority;
+	std::vector<std::list<Out_transition>> transitions;
+
+	Record_product(
+		const std::vector<state_t> &starts,
+		const std::vector<state_t> &record,
+		const std::list<Out_transition> *const automaton,
+		const Record_read &read)
+	{
+		for (auto q = starts.cbegin(); q != starts.cend(); q++) {
+			id(*q, record);
+		}
+		for (std::size_t p = 0; p < pairs.size(); p++) {
+			const state_t q = pairs[p]->first.first;
+			std::vector<state_t> r = pairs[p]->first.second;
+			priority.push_back(read(q, r));
+			for (auto t = automaton[q].cbegin(); t != automaton[q].cend(); t++) {
+				const state_t left = id(t->left, r);
+				const state_t right = id(t->right, r);
+				transitions[p].push_back({left, right});
+			}
+		}
+	};
+
+private:
+	state_t id(const state_t q, const std::vector<state_t> &r)
+	{
+		const auto i = ids.emplace(std::make_pair(q, r), pairs.size());
+		if (i.second) {
+			pairs.push_back(i.first);
+			state.push_back(q);
+			transitions.emplace_back();
+		}
+		return static_cast<state_t>(i.first->second);
+	};
+};
+
+// unfolds the strategy move of a product from its first pair into a run of
+// the automaton: the node of a pair is a leaf when the nearest ancestor of its
+// state or the graft of its state (the first internal node of the state)
+// belongs to the same pair, since the run continues from there as the
+// product does; a strategy may need more memory than that, so the unfolding
+// gives up past budget internal nodes or a path longer than the product,
+// unless it is loose, and then a path is also cut at a pair already on it,
+// leaving to a check of the run whether its paths are still accepted
+class Run_folder final
+{
+	const Record_product &product;
+	const std::vector<const Out_transition *> &move;
+	const bool loose;
+	std::vector<std::size_t> last;
+	std::vector<std::size_t> graft;
+	std::vector<char> on_path;
+	std::size_t budget;
+
+public:
+	bool failed;
+
+	Run_folder(
+		const state_t n,
+		const Record_product &p,
+		const std::vector<const Out_transition *> &m,
+		const bool l)
+		: product{p}
+		, move{m}
+		, loose{l}
+		, last(n, NO_MOVE)
+		, graft(n, NO_MOVE)
+		, on_path(p.state.size(), 0)
+		, budget{64 * p.state.size() + n}
+		, failed{false} {};
+
+	Run_node *fold(const std::size_t p, Run_node *const parent, const std::size_t depth)
+	{
+		const state_t q = product.state[p];
+		Run_node *const n = new Run_node(q, parent);
+		if (last[q] == p || (loose && on_path[p] && NO_MOVE != last[q])) {
+			return n;
+		}
+		if (graft[q] == p) {
+			n->graft = true;
+			return n;
+		}
+		if (0 == budget || product.state.size() < depth) {
+			failed = true;
+			return n;
+		}
+		budget--;
+		if (NO_MOVE == graft[q]) {
+			graft[q] = p;
+		}
+		const std::size_t above = last[q];
+		const char seen = on_path[p];
+		last[q] = p;
+		on_path[p] = 1;
+		n->left = fold(move[p]->left, n, depth + 1);
+		n->right = fold(move[p]->right, n, depth + 1);
+		on_path[p] = seen;
+		last[q] = above;
+		return n;
+	};
+};
+
+// the appearance record of the Streett pairs (e, f), kept as (l, u), for the
+// product of find_record_run, with the priorities raised by shift
+Record_read
+streett_record(const std::list<Acceptance> &streett, const unsigned int shift, std::vector<state_t> &record)
+{
+	std::vector<const Acceptance *> pairs;
+	for (auto a = streett.cbegin(); a != streett.cend(); a++) {
+		record.push_back(pairs.size());
+		pairs.push_back(&*a);
+	}
+	return [pairs, shift](const state_t q, std::vector<state_t> &r) -> unsigned int {
+		const std::size_t k = r.size();
+		std::size_t e = k;
+		std::size_t f = k;
+		std::vector<state_t> visited;
+		std::vector<state_t> rest;
+		for (std::size_t i = 0; i < k; i++) {
+			if (pairs[r[i]]->u.test(q)) {
+				f = std::min(f, i);
+				visited.push_back(r[i]);
+			} else {
+				if (pairs[r[i]]->l.test(q)) {
+					e = std::min(e, i);
+				}
+				rest.push_back(r[i]);
+			}
+		}
+		rest.insert(rest.end(), visited.cbegin(), visited.cend());
+		r = std::move(rest);
+		return static_cast<unsigned int>(((e < f) ? 2 * e + 1 : 2 * f) + shift);
+	};
+}
+
+// the appearance record of the Muller sets of an automaton with n states
+Record_read
+muller_record(const std::list<bitset_t> &muller, const state_t n, std::vector<state_t> &record)
+{
+	const std::set<bitset_t> sets(muller.cbegin(), muller.cend());
+	for (state_t q = 0; q < n; q++) {
+		record.push_back(q);
+	}
+	return [sets, n](const state_t q, std::vector<state_t> &r) -> unsigned int {
+		const std::size_t h = std::find(r.cbegin(), r.cend(), q) - r.cbegin();
+		bitset_t recent(n);
+		for (std::size_t i = 0; i <= h; i++) {
+			recent.set(r[i]);
+		}
+		std::rotate(r.begin(), r.begin() + h, r.begin() + h + 1);
+		return static_cast<unsigned int>(2 * (n - 1 - h) + (sets.count(recent) ? 0 : 1));
+	};
+}
+} // namespace
+
+// whether the acceptance conditions, once sorted by the size of l, form a
+// chain where the l and u of every condition are contained in the l of the
+// next one (as in parity and Büchi conditions encoded as Rabin pairs), and
+// then the priority of every state: 2i + 2 in the u of the i-th condition,
+// 2i + 1 in its l but in no earlier condition, and odd outside of them all
+bool
+Rabin_automaton::parity_priorities(std::vector<unsigned int> &priority) const
+{
+	std::vector<const Acceptance *> chain;
+	for (auto a = conditions.cbegin(); a != conditions.cend(); a++) {
+		chain.push_back(&*a);
+	}
+	std::sort(chain.begin(), chain.end(), [](const Acceptance *const a, const Acceptance *const b) {
+		return a->l.count() < b->l.count();
+	});
+	chain.erase(
+		std::unique(
+			chain.begin(),
+			chain.end(),
+			[](const Acceptance *const a, const Acceptance *const b) { return a->l == b->l && a->u == b->u; }),
+		chain.end());
+	for (std::size_t i = 0; i + 1 < chain.size(); i++) {
+		if (!chain[i]->l.is_subset_of(chain[i + 1]->l) || !chain[i]->u.is_subset_of(chain[i + 1]->l)) {
+			return false;
+		}
+	}
+	priority.assign(states, static_cast<unsigned int>(2 * chain.size() + 1));
+	for (std::size_t i = chain.size(); 0 < i--;) {
+		for (auto q = chain[i]->l.find_first(); chain[i]->l.npos != q; q = chain[i]->l.find_next(q)) {
+			priority[q] = static_cast<unsigned int>(2 * i + 1);
+		}
+		for (auto q = chain[i]->u.find_first(); chain[i]->u.npos != q; q = chain[i]->u.find_next(q)) {
+			priority[q] = static_cast<unsigned int>(2 * i + 2);
+		}
+	}
+	return true;
+}
+
+// solves the emptiness game of the automaton with the priorities of
+// parity_priorities, a path being accepted exactly when the lowest priority
+// it visits infinitely often is even; the positional strategy of the
+// automaton on the states it wins is a run with a node for each state
+Run *
+Rabin_automaton::find_parity_run(const std::vector<unsigned int> &priority) const
+{
+	Parity_game game(states, priority, transitions);
+	const std::vector<std::size_t> won = game.solve();
+	std::vector<const Out_transition *> move(states, nullptr);
+	bool nonempty = false;
+	for (auto v = won.cbegin(); v != won.cend(); v++) {
+		if (*v < states) {
+			move[*v] = game.transition[game.strategy[*v]];
+			nonempty = nonempty || all_states || starting_state == *v;
+		}
+	}
+	return nonempty ? strategy_run(move) : nullptr;
+}
+
+// Streett and Muller automata are solved as the parity game of their product
+// with an appearance record: for Streett pairs the record orders the pairs
+// by the last visit of their f, and reading a state has priority 2i + 1 when
+// the first pair at position i whose e contains it comes before the first one
+// at position i whose f contains it, 2i otherwise (eventually the pairs
+// whose f is visited finitely often are the first ones, and those are the
+// ones whose e must be visited finitely often); for Muller sets the record
+// orders the states by their last visit, and reading the state at position h
+// has a priority decreasing with h, even when the states up to position h
+// are a Muller set (eventually the largest position read infinitely often
+// closes the set of the states visited infinitely often)
+Run *
+Rabin_automaton::find_record_run() const
+{
+	std::vector<state_t> record;
+	const Record_read read = (ACCEPTANCE_STREETT == kind) ? streett_record(streett_pairs, 0, record)
+														  : muller_record(muller_sets, states, record);
+	std::vector<state_t> starts(1, starting_state);
+	for (state_t q = 0; all_states && q < states; q++) {
+		if (q != starting_state) {
+			starts.push_back(q);
+		}
+	}
+	const Record_product product(starts, record, transitions, read);
+	Parity_game game(product.state.size(), product.priority, product.transitions.data());
+	const std::vector<std::size_t> won = game.solve();
+	std::vector<const Out_transition *> move(product.state.size(), nullptr);
+	for (auto v = won.cbegin(); v != won.cend(); v++) {
+		if (*v < product.state.size()) {
+			move[*v] = game.transition[game.strategy[*v]];
+		}
+	}
+	// the first pairs won, each unfolded unless its state is already nonempty
+	std::vector<std::size_t> roots;
+	for (std::size_t p = 0; p < starts.size(); p++) {
+		if (nullptr != move[p]) {
+			roots.push_back(p);
+		}
+	}
+	if (roots.empty() || (!all_states && 0 != roots.front())) {
+		return nullptr;
+	}
+	for (const bool loose : {false, true}) {
+		Run_folder folder(states, product, move, loose);
+		Run *const res = new Run(states, starting_state);
+		for (auto p = roots.cbegin(); !folder.failed && p != roots.cend(); p++) {
+			if (res->nonempty(product.state[*p])) {
+				continue;
+			}
+			Run_node *const root = folder.fold(*p, nullptr, 0);
+			if (folder.failed) {
+				delete root;
+			} else {
+				res->save_subruns(root);
+			}
+		}
+		if (!folder.failed && (!loose || verify(*res))) {
+			return res;
+		}
+		delete res;
+	}
+	throw std::runtime_error("the language of the automaton is nonempty, but its accepted run found needs more "
+							 "memory than a run of bracket can express");
+}
+
+// the certificate of an empty language is the strategy of player 1 in the
+// emptiness game: the game of the automaton itself when its conditions form
+// a parity condition, where both players have positional strategies, or
+// otherwise the game of its product with the appearance record of
+// find_record_run, Rabin pairs (l, u) being read as the Streett pairs (u, l)
+// of the rejected paths and so their priorities shifted by one; the nodes of
+// the certificate are the pairs won by player 1 reached from the first one
+// through the moves of player 1 on their transitions
+Certificate *
+Rabin_automaton::find_certificate() const
+{
+	std::vector<unsigned int> priority;
+	std::list<Acceptance> rejected;
+	std::vector<state_t> record;
+	Record_read read;
+	if (ACCEPTANCE_MULLER == kind) {
+		read = muller_record(muller_sets, states, record);
+	} else if (ACCEPTANCE_STREETT == kind) {
+		read = streett_record(streett_pairs, 0, record);
+	} else if (parity_priorities(priority)) {
+		read = [&priority](const state_t q, std::vector<state_t> &) { return priority[q]; };
+	} else {
+		for (auto a = conditions.cbegin(); a != conditions.cend(); a++) {
+			rejected.emplace_back(a->u, a->l);
+		}
+		read = streett_record(rejected, 1, record);
+	}
+	const Record_product product(std::vector<state_t>(1, starting_state), record, transitions, read);
+	const std::size_t n = product.state.size();
+	Parity_game game(n, product.priority, product.transitions.data());
+	const std::vector<std::size_t> won = game.solve();
+	if (std::find(won.cbegin(), won.cend(), 0) != won.cend()) {
+		return nullptr;
+	}
+	Certificate *const res = new Certificate;
+	std::vector<std::size_t> id(n, NO_MOVE);
+	std::vector<std::size_t> order(1, 0);
+	id[0] = 0;
+	for (std::size_t i = 0; i < order.size(); i++) {
+		res->state.push_back(product.state[order[i]]);
+		for (auto w = game.moves(order[i]).cbegin(); w != game.moves(order[i]).cend(); w++) {
+			const std::size_t p = game.strategy[*w];
+			if (NO_MOVE == id[p]) {
+				id[p] = order.size();
+				order.push_back(p);
+			}
+			res->child.push_back(id[p]);
+		}
+		res->first.push_back(res->child.size());
+	}
+	return res;
+}
@@ -0,0 +1,70 @@
+#include <cerrno>
+#include <csignal>
+#include <ctime>
+#include <iostream>
+#include <pthread.h>
+
+#include "progress.h"
+
+std::ostream &
+operator<<(std::ostream &os, const Search_progress &p)
+{
+	const double elapsed = std::chrono::duration<double>(search_clock::now() - p.start).count();
+	const state_t states = p.states.load(std::memory_order_relaxed);
+	os << "progress: ";
+	if (0 == states) {
+		return os << "before the search, " << elapsed << " s";
+	}
+	const counter_t total = p.total.load(std::memory_order_relaxed);
+	os << "height " << p.height.load(std::memory_order_relaxed) << " of " << states << ", "
+	   << p.pieces.load(std::memory_order_relaxed) << " pieces, " << p.generated.load(std::memory_order_relaxed)
+	   << " generated at this height, " << p.nonempty.load(std::memory_order_relaxed) << " nonempty states, ";
+	if (0 < elapsed) {
+		os << static_cast<counter_t>(total / elapsed) << " pieces/s, ";
+	}
+	return os << elapsed << " s";
+}
+
+void
+block_progress_signal(sigset_t *const old)
+{
+	sigset_t set;
+	sigemptyset(&set);
+	sigaddset(&set, SIGUSR1);
+	pthread_sigmask(SIG_BLOCK, &set, old);
+}
+
+Progress_reporter::Progress_reporter(const Search_progress &p, const unsigned int i)
+	: progress{p}, interval{i}, stop{false}
+{
+	block_progress_signal(&mask);
+	thread = std::thread(&Progress_reporter::loop, this);
+}
+
+// the reporter is woken by a signal directed to its thread
+Progress_reporter::~Progress_reporter()
+{
+	stop = true;
+	pthread_kill(thread.native_handle(), SIGUSR1);
+	thread.join();
+	pthread_sigmask(SIG_SETMASK, &mask, nullptr);
+}
+
+void
+Progress_reporter::loop()
+{
+	sigset_t set;
+	sigemptyset(&set);
+	sigaddset(&set, SIGUSR1);
+	const struct timespec timeout = {static_cast<time_t>(interval), 0};
+	while (!stop) {
+		const int res = (0 < interval) ? sigtimedwait(&set, nullptr, &timeout) : sigwaitinfo(&set, nullptr);
+		if (stop) {
+			break;
+		}
+		if (-1 == res && EINTR == errno) {
+			continue;
+		}
+		std::cerr << progress << std::endl;
+	}
+}
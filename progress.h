@@ -0,0 +1,73 @@
+#ifndef PROGRESS_H
+#define PROGRESS_H
+
+#include <atomic>
+#include <csignal>
+#include <ostream>
+#include <thread>
+
+#include "search_stats.h"
+
+// counters of the search that another thread reads while it runs: the main
+// thread of the search sets them between its phases, the workers add the
+// pieces they generated once per task
+class Search_progress final
+{
+public:
+	const search_clock::time_point start;
+	// the states of the automaton being searched, 0 before the search
+	std::atomic<state_t> states;
+	std::atomic<state_t> height;
+	// the pieces in the tables at the end of the previous height
+	std::atomic<counter_t> pieces;
+	// the pieces generated at the current height and at every height
+	std::atomic<counter_t> generated;
+	std::atomic<counter_t> total;
+	std::atomic<state_t> nonempty;
+
+	Search_progress()
+		: start{search_clock::now()}, states{0}, height{0}, pieces{0}, generated{0}, total{0}, nonempty{0} {};
+	Search_progress(const Search_progress &) = delete;
+	Search_progress(Search_progress &&) = delete;
+	Search_progress &operator=(const Search_progress &) = delete;
+	Search_progress &operator=(Search_progress &&) = delete;
+
+	void add(const counter_t n)
+	{
+		generated.fetch_add(n, std::memory_order_relaxed);
+		total.fetch_add(n, std::memory_order_relaxed);
+	};
+};
+std::ostream &operator<<(std::ostream &, const Search_progress &);
+
+// blocks SIGUSR1 in the calling thread and in the threads it creates from
+// then on, storing the previous signal mask in old unless it is nullptr
+void block_progress_signal(sigset_t *const old);
+
+// prints the progress to the standard error whenever the process receives
+// SIGUSR1 and, with a positive interval, every interval seconds; SIGUSR1 is
+// blocked in the constructing thread and in the threads it creates while the
+// reporter lives, so that only the reporter takes it, and the main function
+// blocks it before parsing so that a signal sent earlier waits for it
+class Progress_reporter final
+{
+	const Search_progress &progress;
+	const unsigned int interval;
+	std::atomic<bool> stop;
+	// the signal mask of the constructing thread before the reporter
+	sigset_t mask;
+	std::thread thread;
+
+public:
+	Progress_reporter(const Search_progress &, const unsigned int);
+	Progress_reporter(const Progress_reporter &) = delete;
+	Progress_reporter(Progress_reporter &&) = delete;
+	~Progress_reporter();
+	Progress_reporter &operator=(const Progress_reporter &) = delete;
+	Progress_reporter &operator=(Progress_reporter &&) = delete;
+
+private:
+	void loop();
+};
+
+#endif
@@ -0,0 +1,234 @@
+#include <stack>
+#include <vector>
+
+#include "rabin_automaton.h"
+
+namespace
+{
+// the transitions of an automaton whose states and children are all alive,
+// states left without such transitions die in turn
+class Alive_graph final
+{
+	struct Edge
+	{
+		state_t from;
+		state_t left;
+		state_t right;
+		bool alive;
+	};
+
+	std::vector<Edge> edges;
+	std::vector<std::vector<std::size_t>> uses;
+	std::vector<std::size_t> out;
+
+public:
+	std::vector<bool> alive;
+
+	Alive_graph(const state_t n, const std::list<Out_transition> *const transitions)
+		: uses(n), out(n, 0), alive(n, true)
+	{
+		for (state_t q = 0; q < n; q++) {
+			for (auto t = transitions[q].cbegin(); t != transitions[q].cend(); t++) {
+				uses[t->left].push_back(edges.size());
+				if (t->right != t->left) {
+					uses[t->right].push_back(edges.size());
+				}
+				edges.push_back({q, t->left, t->right, true});
+				out[q]++;
+			}
+		}
+		for (state_t q = 0; q < n; q++) {
+			if (0 == out[q]) {
+				kill(q);
+			}
+		}
+	};
+
+	void kill(const state_t q)
+	{
+		std::stack<state_t> stack;
+		for (stack.push(q); !stack.empty();) {
+			const state_t p = stack.top();
+			stack.pop();
+			if (!alive[p]) {
+				continue;
+			}
+			alive[p] = false;
+			for (auto e = uses[p].cbegin(); e != uses[p].cend(); e++) {
+				if (edges[*e].alive) {
+					edges[*e].alive = false;
+					if (0 == --out[edges[*e].from]) {
+						stack.push(edges[*e].from);
+					}
+				}
+			}
+		}
+	};
+
+	// the successors of the states through the transitions that are alive
+	std::vector<std::vector<state_t>> successors() const
+	{
+		std::vector<std::vector<state_t>> res(alive.size());
+		for (auto e = edges.cbegin(); e != edges.cend(); e++) {
+			if (e->alive) {
+				res[e->from].push_back(e->left);
+				res[e->from].push_back(e->right);
+			}
+		}
+		return res;
+	};
+};
+
+// the states of u lying on a cycle of the successors that avoids l, through
+// the strongly connected components of the states not in l
+std::vector<bool>
+good_states(const std::vector<std::vector<state_t>> &succ, const std::vector<bool> &alive, const Acceptance &a)
+{
+	const state_t n = succ.size();
+	std::vector<bool> res(n, false);
+	std::vector<state_t> index(n, STATE_MAX);
+	std::vector<state_t> low(n, 0);
+	std::vector<bool> on_stack(n, false);
+	std::vector<state_t> stack;
+	std::vector<std::pair<state_t, std::size_t>> calls;
+	state_t next = 0;
+	const auto usable = [&alive, &a](const state_t q) { return alive[q] && !a.l.test(q); };
+	for (state_t r = 0; r < n; r++) {
+		if (!usable(r) || STATE_MAX != index[r]) {
+			continue;
+		}
+		calls.emplace_back(r, 0);
+		index[r] = low[r] = next++;
+		stack.push_back(r);
+		on_stack[r] = true;
+		while (!calls.empty()) {
+			const state_t q = calls.back().first;
+			std::size_t &i = calls.back().second;
+			if (i < succ[q].size()) {
+				const state_t p = succ[q][i++];
+				if (!usable(p)) {
+					continue;
+				}
+				if (STATE_MAX == index[p]) {
+					index[p] = low[p] = next++;
+					stack.push_back(p);
+					on_stack[p] = true;
+					calls.emplace_back(p, 0);
+				} else if (on_stack[p] && index[p] < low[q]) {
+					low[q] = index[p];
+				}
+				continue;
+			}
+			calls.pop_back();
+			if (!calls.empty() && low[q] < low[calls.back().first]) {
+				low[calls.back().first] = low[q];
+			}
+			if (low[q] != index[q]) {
+				continue;
+			}
+			// q is the root of a component, that has a cycle if it has more
+			// than a state or a self loop
+			bool cycle = stack.back() != q;
+			for (auto p = succ[q].cbegin(); !cycle && p != succ[q].cend(); p++) {
+				cycle = *p == q;
+			}
+			state_t p = STATE_MAX;
+			do {
+				p = stack.back();
+				stack.pop_back();
+				on_stack[p] = false;
+				res[p] = cycle && a.u.test(p);
+			} while (p != q);
+		}
+	}
+	return res;
+}
+
+// the states reaching one of the targets through the successors
+std::vector<bool>
+reaching(const std::vector<std::vector<state_t>> &succ, const std::vector<bool> &targets)
+{
+	const state_t n = succ.size();
+	std::vector<std::vector<state_t>> pred(n);
+	for (state_t q = 0; q < n; q++) {
+		for (auto p = succ[q].cbegin(); p != succ[q].cend(); p++) {
+			pred[*p].push_back(q);
+		}
+	}
+	std::vector<bool> res(targets);
+	std::stack<state_t> stack;
+	for (state_t q = 0; q < n; q++) {
+		if (res[q]) {
+			stack.push(q);
+		}
+	}
+	while (!stack.empty()) {
+		const state_t q = stack.top();
+		stack.pop();
+		for (auto p = pred[q].cbegin(); p != pred[q].cend(); p++) {
+			if (!res[*p]) {
+				res[*p] = true;
+				stack.push(*p);
+			}
+		}
+	}
+	return res;
+}
+} // namespace
+
+// the enabled checks are tried in order, each one proving emptiness when the
+// starting state has no infinite tree of transitions (CHECK_PRODUCTIVE), or
+// reaches no state of some u on a cycle avoiding the corresponding l
+// (CHECK_CYCLES), or is removed while the states reaching none of those
+// cycles are removed until nothing changes (CHECK_PRUNING); the last two
+// only apply to Rabin pairs
+bool
+Rabin_automaton::quick_empty(Search_stats *const stats) const
+{
+	const auto fired = [stats](const Emptiness_check c) {
+		if (nullptr != stats) {
+			stats->checks_fired[c]++;
+		}
+		return true;
+	};
+	if (0 == (checks & ((1 << CHECKS) - 1))) {
+		return false;
+	}
+	Alive_graph g(states, transitions);
+	if ((checks & (1 << CHECK_PRODUCTIVE)) && !g.alive[starting_state]) {
+		return fired(CHECK_PRODUCTIVE);
+	}
+	for (int c = CHECK_CYCLES; c <= CHECK_PRUNING; c++) {
+		if (!(checks & (1 << c)) || ACCEPTANCE_RABIN != kind) {
+			continue;
+		}
+		for (bool changed = true; changed && g.alive[starting_state];) {
+			const std::vector<std::vector<state_t>> succ = g.successors();
+			std::vector<bool> good(states, false);
+			for (auto a = conditions.cbegin(); a != conditions.cend(); a++) {
+				const std::vector<bool> tmp = good_states(succ, g.alive, *a);
+				for (state_t q = 0; q < states; q++) {
+					good[q] = good[q] || tmp[q];
+				}
+			}
+			const std::vector<bool> live = reaching(succ, good);
+			if (CHECK_CYCLES == c) {
+				if (!live[starting_state]) {
+					return fired(CHECK_CYCLES);
+				}
+				break;
+			}
+			changed = false;
+			for (state_t q = 0; q < states; q++) {
+				if (g.alive[q] && !live[q]) {
+					g.kill(q);
+					changed = true;
+				}
+			}
+		}
+		if (!g.alive[starting_state]) {
+			return fired(static_cast<Emptiness_check>(c));
+		}
+	}
+	return false;
+}
@@ -0,0 +1,319 @@
+#include <algorithm>
+#include <map>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "rabin_automaton.h"
+
+namespace
+{
+// builds runs of an automaton out of the dependency trees of a run of its
+// quotient, every node of a tree is mapped to a state of its class: first
+// keeping the shape of the tree, then unrolling the leaves whose lowest
+// ancestor of the same class has another state into a copy of that ancestor
+class Run_lifter final
+{
+	const std::list<Out_transition> *const transitions;
+	const std::list<Acceptance> &conditions;
+	const std::vector<state_t> &cls;
+	const Run &quotient;
+	Run &res;
+	std::unordered_set<const Run_node *> lifting;
+	std::size_t budget;
+
+	struct Tree final
+	{
+		const Run_node *root;
+		const Run_node *target;
+		state_t target_state;
+		// the ancestors of the current node and the nodes of the quotient
+		// they are mapped from
+		std::vector<std::pair<const Run_node *, const Run_node *>> path;
+		std::unordered_map<const Run_node *, const Run_node *> from;
+		// graft leaves referring to a state that the tree itself makes nonempty
+		std::vector<const Run_node *> pending;
+		bool unroll;
+		// depth of the unrolled copies the current node is in
+		std::size_t copies;
+	};
+
+public:
+	Run_lifter(
+		const std::list<Out_transition> *const t,
+		const std::list<Acceptance> &a,
+		const std::vector<state_t> &c,
+		const Run &q,
+		Run &r)
+		: transitions{t}
+		, conditions{a}
+		, cls{c}
+		, quotient{q}
+		, res{r}
+		, budget{64 * static_cast<std::size_t>(c.size()) + 4096} {};
+
+	// makes p nonempty in the lifted run by lifting the tree of the graft of
+	// the class of p in the quotient, with that graft mapped to p
+	bool ensure(const state_t p)
+	{
+		if (res.nonempty(p)) {
+			return true;
+		}
+		const Run_node *const n = quotient.graft(cls[p]);
+		const Run_node *const d = quotient.dependency(cls[p]);
+		if (nullptr == n || lifting.end() != lifting.find(d)) {
+			return false;
+		}
+		lifting.insert(d);
+		Run_node *root = nullptr;
+		// the tree is lifted keeping its shape, then unrolled, then unrolled
+		// from the graft of the class of p alone
+		for (int attempt = 0; attempt < 3 && nullptr == root; attempt++) {
+			Tree t{d, n, p, {}, {}, {}, 0 < attempt, 0};
+			if (2 == attempt) {
+				root = assign(t, n, p, nullptr);
+			}
+			for (state_t r = 0; r < cls.size() && nullptr == root && 2 > attempt; r++) {
+				if (cls[r] == d->state) {
+					root = assign(t, d, r, nullptr);
+				}
+			}
+			if (nullptr != root && !valid(t, root)) {
+				delete root;
+				root = nullptr;
+			}
+		}
+		lifting.erase(d);
+		if (nullptr == root) {
+			return false;
+		}
+		res.save_subruns(root);
+		return res.nonempty(p);
+	};
+
+private:
+	Run_node *assign(Tree &t, const Run_node *const x, const state_t s, Run_node *const p)
+	{
+		if (0 == budget || (x == t.target && s != t.target_state && 0 == t.copies)) {
+			return nullptr;
+		}
+		budget--;
+		if (nullptr == x->left) {
+			const bool own = x->graft && quotient.dependency(cls[s]) == t.root && !res.nonempty(s);
+			if (x->graft && !own) {
+				if (!ensure(s)) {
+					return nullptr;
+				}
+				Run_node *const n = new Run_node(s, p);
+				n->graft = true;
+				return n;
+			}
+			if (own && !t.unroll) {
+				// the graft of the class must be the first node of the state
+				for (auto a = t.path.cbegin(); a != t.path.cend(); a++) {
+					if (a->first == quotient.graft(cls[s]) && a->second->state != s) {
+						return nullptr;
+					}
+				}
+				Run_node *const n = new Run_node(s, p);
+				n->graft = true;
+				t.pending.push_back(n);
+				return n;
+			}
+			// the graft leaves referring to the tree itself are unrolled as
+			// well, into a copy of the graft of their class
+			const Run_node *const y = own ? quotient.graft(cls[s]) : x;
+			for (auto a = t.path.crbegin(); a != t.path.crend(); a++) {
+				if (a->second->state == s) {
+					return new Run_node(s, p);
+				}
+				if (!t.unroll && a->first->state == y->state) {
+					return nullptr;
+				}
+			}
+			const Run_node *z = own ? y : x->parent;
+			for (; nullptr != z && z->state != y->state; z = z->parent) {
+			}
+			if (!t.unroll || nullptr == z) {
+				return nullptr;
+			}
+			t.copies++;
+			Run_node *const n = assign(t, z, s, p);
+			t.copies--;
+			return n;
+		}
+		Run_node *const n = new Run_node(s, p);
+		t.from[n] = x;
+		t.path.emplace_back(x, n);
+		const std::size_t pending = t.pending.size();
+		for (auto r = transitions[s].cbegin(); r != transitions[s].cend(); r++) {
+			if (cls[r->left] != x->left->state || cls[r->right] != x->right->state) {
+				continue;
+			}
+			n->left = assign(t, x->left, r->left, n);
+			if (nullptr != n->left) {
+				n->right = assign(t, x->right, r->right, n);
+				if (nullptr != n->right) {
+					t.path.pop_back();
+					return n;
+				}
+				delete n->left;
+				n->left = nullptr;
+			}
+			t.pending.resize(pending);
+		}
+		t.path.pop_back();
+		t.from.erase(n);
+		delete n;
+		return nullptr;
+	};
+
+	// the leaves must satisfy the acceptance condition of the runs, and the
+	// graft leaves of the tree must refer to the same nodes as in the
+	// quotient, that is the first node of their state in preorder must be
+	// mapped from the graft of their class
+	bool valid(Tree &t, const Run_node *const root) const
+	{
+		std::unordered_map<state_t, const Run_node *> first;
+		std::unordered_map<const Run_node *, bitset_t> internal;
+		std::vector<const Run_node *> leaves;
+		std::vector<const Run_node *> stack{root};
+		while (!stack.empty()) {
+			const Run_node *const x = stack.back();
+			stack.pop_back();
+			if (nullptr == x->left) {
+				if (!x->graft) {
+					leaves.push_back(x);
+				}
+				continue;
+			}
+			first.emplace(x->state, x);
+			for (const Run_node *y = x->parent; nullptr != y; y = y->parent) {
+				internal.emplace(y, bitset_t(cls.size())).first->second.set(x->state);
+			}
+			stack.push_back(x->right);
+			stack.push_back(x->left);
+		}
+		for (auto n = t.pending.cbegin(); n != t.pending.cend(); n++) {
+			const auto f = first.find((*n)->state);
+			if (!res.nonempty((*n)->state)
+				&& (first.end() == f || t.from.at(f->second) != quotient.graft(cls[(*n)->state]))) {
+				return false;
+			}
+		}
+		for (auto x = leaves.cbegin(); x != leaves.cend(); x++) {
+			const Run_node *top = nullptr;
+			for (const Run_node *y = (*x)->parent; nullptr != y; y = y->parent) {
+				if (y->state == (*x)->state) {
+					top = y;
+				}
+			}
+			const auto i = internal.find(top);
+			bool accepted = false;
+			for (auto a = conditions.cbegin(); a != conditions.cend() && !accepted; a++) {
+				accepted = a->u.test((*x)->state) && (internal.end() == i || !i->second.intersects(a->l));
+			}
+			if (!accepted) {
+				return false;
+			}
+		}
+		return true;
+	};
+};
+} // namespace
+
+// partition refinement of the states with the same membership in every
+// acceptance condition, until the states of a class have the same pairs of
+// classes of successors
+Rabin_automaton *
+Rabin_automaton::quotient(std::vector<state_t> &cls) const
+{
+	if (!has_transitions || conditions.empty()) {
+		return nullptr;
+	}
+	cls.assign(states, 0);
+	std::size_t classes = 0;
+	for (std::vector<state_t> key;;) {
+		std::map<std::vector<state_t>, state_t> ids;
+		std::vector<state_t> next(states);
+		for (state_t q = 0; q < states; q++) {
+			key.clear();
+			if (0 == classes) {
+				for (auto a = conditions.cbegin(); a != conditions.cend(); a++) {
+					key.push_back(a->l.test(q) ? 1 : (a->u.test(q) ? 2 : 0));
+				}
+			} else {
+				std::vector<std::pair<state_t, state_t>> succ;
+				for (auto t = transitions[q].cbegin(); t != transitions[q].cend(); t++) {
+					succ.emplace_back(cls[t->left], cls[t->right]);
+				}
+				std::sort(succ.begin(), succ.end());
+				succ.erase(std::unique(succ.begin(), succ.end()), succ.end());
+				key.push_back(cls[q]);
+				for (auto t = succ.cbegin(); t != succ.cend(); t++) {
+					key.push_back(t->first);
+					key.push_back(t->second);
+				}
+			}
+			// the classes are numbered by their first state
+			const auto i = ids.emplace(key, ids.size()).first;
+			next[q] = i->second;
+		}
+		cls.swap(next);
+		if (ids.size() == classes) {
+			break;
+		}
+		classes = ids.size();
+	}
+	if (classes == states) {
+		return nullptr;
+	}
+	Rabin_automaton *const res = new Rabin_automaton(classes);
+	res->set_start(cls[starting_state]);
+	res->set_deterministic(deterministic);
+	res->set_symmetry_bound(symmetry_bound);
+	res->set_checkpoint(checkpoint, checkpoint_heights, checkpoint_seconds);
+	std::vector<bool> done(classes, false);
+	for (state_t q = 0; q < states; q++) {
+		if (done[cls[q]]) {
+			continue;
+		}
+		done[cls[q]] = true;
+		std::vector<std::pair<state_t, state_t>> succ;
+		for (auto t = transitions[q].cbegin(); t != transitions[q].cend(); t++) {
+			succ.emplace_back(cls[t->left], cls[t->right]);
+		}
+		std::sort(succ.begin(), succ.end());
+		succ.erase(std::unique(succ.begin(), succ.end()), succ.end());
+		for (auto t = succ.cbegin(); t != succ.cend(); t++) {
+			res->add_transition(cls[q], t->first, t->second);
+		}
+	}
+	for (auto a = conditions.cbegin(); a != conditions.cend(); a++) {
+		bitset_t l(classes);
+		bitset_t u(classes);
+		for (state_t q = 0; q < states; q++) {
+			if (a->l.test(q)) {
+				l.set(cls[q]);
+			}
+			if (a->u.test(q)) {
+				u.set(cls[q]);
+			}
+		}
+		res->add_acceptance(std::move(l), std::move(u));
+	}
+	return res;
+}
+
+// maps a run of the quotient to a run of the automaton, returns nullptr if the
+// bounded search of the mapping fails
+Run *
+Rabin_automaton::lift_run(const Run &run, const std::vector<state_t> &cls) const
+{
+	Run *res = new Run(states, starting_state);
+	Run_lifter lifter(transitions, conditions, cls, run, *res);
+	if (!lifter.ensure(starting_state)) {
+		delete res;
+		res = nullptr;
+	}
+	return res;
+}
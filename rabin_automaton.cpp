@@ -1,20 +1,57 @@
 #include <algorithm>
+#include <atomic>
+#include <cerrno>
 #include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
 #include <functional>
+#include <iostream>
+#include <mutex>
 #include <queue>
+#include <sstream>
 #include <stdexcept>
+#include <string>
 #include <thread>
 #include <tuple>
+#include <unistd.h>
+#include <unordered_map>
+#include <utility>
 
 #include "rabin_automaton.h"
+#include "state_set.h"
 
-Rabin_automaton::Rabin_automaton(const state_t state_num) : states{state_num}, starting_state{0}, has_transitions{false}
+Rabin_automaton::Rabin_automaton(const state_t state_num)
+	: states{state_num}
+	, starting_state{0}
+	, has_transitions{false}
+	, kind{ACCEPTANCE_RABIN}
+	, checks{ALL_CHECKS}
+	, deterministic{false}
+	, symmetry_bound{SYMMETRY_BOUND}
+	, all_states{false}
+	, checkpoint{nullptr}
+	, checkpoint_heights{1}
+	, checkpoint_seconds{0}
+	, resume{nullptr}
 {
 	transitions = new std::list<Out_transition>[states];
 }
 
 Rabin_automaton::Rabin_automaton(const Rabin_automaton &arg)
-	: states{arg.states}, starting_state{arg.starting_state}, has_transitions{arg.has_transitions}
+	: states{arg.states}
+	, starting_state{arg.starting_state}
+	, has_transitions{arg.has_transitions}
+	, kind{arg.kind}
+	, checks{arg.checks}
+	, deterministic{arg.deterministic}
+	, symmetry_bound{arg.symmetry_bound}
+	, all_states{arg.all_states}
+	, checkpoint{arg.checkpoint}
+	, checkpoint_heights{arg.checkpoint_heights}
+	, checkpoint_seconds{arg.checkpoint_seconds}
+	, resume{arg.resume}
 {
 	if (this == &arg) {
 		return;
@@ -24,6 +61,8 @@ Rabin_automaton::Rabin_automaton(const Rabin_automaton &arg)
 		transitions[s] = arg.transitions[s];
 	}
 	conditions = arg.conditions;
+	streett_pairs = arg.streett_pairs;
+	muller_sets = arg.muller_sets;
 }
 
 Rabin_automaton::Rabin_automaton(Rabin_automaton &&arg)
@@ -31,7 +70,18 @@ Rabin_automaton::Rabin_automaton(Rabin_automaton &&arg)
 	, starting_state{arg.starting_state}
 	, has_transitions{arg.has_transitions}
 	, transitions{arg.transitions}
+	, kind{arg.kind}
 	, conditions{std::move(arg.conditions)}
+	, streett_pairs{std::move(arg.streett_pairs)}
+	, muller_sets{std::move(arg.muller_sets)}
+	, checks{arg.checks}
+	, deterministic{arg.deterministic}
+	, symmetry_bound{arg.symmetry_bound}
+	, all_states{arg.all_states}
+	, checkpoint{arg.checkpoint}
+	, checkpoint_heights{arg.checkpoint_heights}
+	, checkpoint_seconds{arg.checkpoint_seconds}
+	, resume{arg.resume}
 {
 	arg.starting_state = 0;
 	arg.has_transitions = false;
@@ -71,8 +121,108 @@ Rabin_automaton::add_acceptance(bitset_t &&l, bitset_t &&u)
 	}
 }
 
+// a Streett pair whose e is contained in f holds on every path
+void
+Rabin_automaton::add_streett_pair(bitset_t &&e, bitset_t &&f)
+{
+	e -= f;
+	if (e.any()) {
+		streett_pairs.emplace_back(std::move(e), std::move(f));
+	}
+}
+
+void
+Rabin_automaton::add_muller_set(bitset_t &&s)
+{
+	muller_sets.push_back(std::move(s));
+}
+
+// Streett and Muller automata are solved as parity games once the quick
+// checks fail to prove emptiness; otherwise, unless the acceptance conditions
+// form a parity condition solved as a game or a run staying in the states of
+// a single acceptance condition is found, the search runs on the quotient of
+// the automaton by bisimulation, whose run is mapped back to the states of the
+// automaton, or on the automaton itself when the quotient has as many states
+// or the mapping fails; with all_states the run found covers every nonempty
+// state and it is returned whenever there is one, the quick checks and the
+// quotient, which only concern the starting state, are skipped and the runs
+// staying in the states of a single condition seed the search; without
+// CHECK_SHORTCUTS the Rabin pairs always go through the search of the
+// automaton itself
+Run *
+Rabin_automaton::find_run(
+	const int max_threads, Search_stats *const stats, Trace *const trace, Search_progress *const progress) const
+{
+	if (1 > max_threads) {
+		throw std::invalid_argument("invalid max_threads (is less than 1)");
+	}
+	if (!all_states && quick_empty(stats)) {
+		return nullptr;
+	}
+	if (ACCEPTANCE_RABIN != kind) {
+		if (nullptr != stats) {
+			stats->parity = true;
+		}
+		return find_record_run();
+	}
+	const bool shortcuts = checks & CHECK_SHORTCUTS;
+	if (shortcuts) {
+		std::vector<unsigned int> priority;
+		const bool parity = parity_priorities(priority);
+		if (nullptr != stats) {
+			stats->parity = parity;
+		}
+		if (parity) {
+			return find_parity_run(priority);
+		}
+	}
+	if (all_states) {
+		return search(max_threads, stats, trace, progress, resume, shortcuts ? find_simple_run() : nullptr);
+	}
+	if (!shortcuts) {
+		return search(max_threads, stats, trace, progress, resume, nullptr);
+	}
+	{
+		Run *const res = find_simple_run();
+		if (nullptr != stats) {
+			stats->simple_run = nullptr != res;
+		}
+		if (nullptr != res) {
+			return res;
+		}
+	}
+	std::vector<state_t> cls;
+	const Rabin_automaton *const q = quotient(cls);
+	if (nullptr != stats) {
+		stats->quotient_states = (nullptr != q) ? q->states : states;
+	}
+	if (nullptr == q) {
+		return search(max_threads, stats, trace, progress, resume, nullptr);
+	}
+	Run *run = nullptr;
+	try {
+		run = q->search(max_threads, stats, trace, progress, resume, nullptr);
+	} catch (...) {
+		delete q;
+		throw;
+	}
+	delete q;
+	if (nullptr == run) {
+		return nullptr;
+	}
+	Run *const res = lift_run(*run, cls);
+	delete run;
+	return (nullptr != res) ? res : search(max_threads, stats, trace, progress, nullptr, nullptr);
+}
+
 Run *
-Rabin_automaton::find_run(const int max_threads) const
+Rabin_automaton::search(
+	const int max_threads,
+	Search_stats *const stats,
+	Trace *const trace,
+	Search_progress *const progress,
+	const char *const resume,
+	Run *const seed) const
 {
 
 	class Run_piece final
@@ -82,15 +232,20 @@ Rabin_automaton::find_run(const int max_threads) const
 	public:
 		state_t state;
 		bool graft;
-		bool invalid;
-		bitset_t internal;
-		bitset_t nonlive;
-		bitset_t all;
-		state_t height;
+		// set concurrently by the workers of the invalidation
+		std::atomic<bool> invalid;
+		State_set internal;
+		State_set nonlive;
+		State_set all;
+		// the pieces standing for the grafts get the height of the piece that
+		// made their state nonempty while the other workers read it
+		std::atomic<state_t> height;
 
 	private:
 		const Run_piece *left;
 		const Run_piece *right;
+		const Run_piece *base;
+		const std::vector<state_t> *perm;
 
 	public:
 		Run_piece(Run &r, const state_t q, const bool g = false, const state_t h = 0)
@@ -104,6 +259,8 @@ Rabin_automaton::find_run(const int max_threads) const
 			, height{h}
 			, left{nullptr}
 			, right{nullptr}
+			, base{nullptr}
+			, perm{nullptr}
 		{
 			if (!graft) {
 				nonlive.set(state);
@@ -119,44 +276,92 @@ Rabin_automaton::find_run(const int max_threads) const
 			, internal{l->run.states}
 			, nonlive{l->run.states}
 			, all{l->run.states}
-			, height{1 + std::max(l->height, r->height)}
+			, height{1 + std::max(l->height.load(), r->height.load())}
+			, base{nullptr}
+			, perm{nullptr}
 		{
 			left = l;
 			right = r;
 			nonlive |= left->nonlive;
 			nonlive |= right->nonlive;
-			nonlive.set(p, false);
+			nonlive.reset(p);
+			// a run of p, saved by the worker
 			if (nonlive.none()) {
-				run.save_subruns(node());
-				graft = true;
-				left = nullptr;
-				right = nullptr;
-				nonlive.reset();
 				return;
 			}
+			internal.set(p);
 			internal |= left->internal;
 			internal |= right->internal;
-			internal.set(p);
+			all.set(p);
 			all |= left->all;
 			all |= right->all;
-			all.set(p);
 		};
 
-		Run_node *node(Run_node *p = nullptr) const
+		// image through the automorphism g of the piece b of the representative
+		// of the orbit of g[b.state], it has the same children as b
+		Run_piece(const Run_piece &b, const std::vector<state_t> &g)
+			: run{b.run}
+			, state{g[b.state]}
+			, graft{b.graft}
+			, invalid{false}
+			, internal{b.run.states}
+			, nonlive{b.run.states}
+			, all{b.run.states}
+			, height{b.height.load()}
+			, left{nullptr}
+			, right{nullptr}
+			, base{&b}
+			, perm{&g}
+		{
+			internal.assign_image(b.internal, g);
+			nonlive.assign_image(b.nonlive, g);
+			all.assign_image(b.all, g);
+		};
+
+		Run_node *node(Run_node *p = nullptr, const std::vector<state_t> *const g = nullptr) const
 		{
-			Run_node *res = new Run_node(state, p);
+			if (nullptr != base) {
+				if (nullptr == g) {
+					return base->node(p, perm);
+				}
+				std::vector<state_t> h(*perm);
+				for (state_t q = 0; q < h.size(); q++) {
+					h[q] = (*g)[(*perm)[q]];
+				}
+				return base->node(p, &h);
+			}
+			Run_node *res = new Run_node((nullptr != g) ? (*g)[state] : state, p);
 			if (graft) {
 				res->graft = true;
 			} else if (nullptr != left) {
-				res->left = left->node(res);
-				res->right = right->node(res);
+				res->left = left->node(res, g);
+				res->right = right->node(res, g);
 			}
 			return res;
 		};
 
+		// the pieces it is made of, for the checkpoints
+		const Run_piece *left_piece() const { return left; };
+		const Run_piece *right_piece() const { return right; };
+		const Run_piece *base_piece() const { return base; };
+
+		void link(
+			const Run_piece *const l,
+			const Run_piece *const r,
+			const Run_piece *const b,
+			const std::vector<state_t> *const g)
+		{
+			left = l;
+			right = r;
+			base = b;
+			perm = g;
+		};
+
 		bool invalid_child() const
 		{
-			return (nullptr != left && left->invalid) || (nullptr != right && right->invalid);
+			return (nullptr != left && left->invalid.load(std::memory_order_relaxed))
+				   || (nullptr != right && right->invalid.load(std::memory_order_relaxed))
+				   || (nullptr != base && base->invalid.load(std::memory_order_relaxed));
 		};
 
 		bool operator<(const Run_piece &rhs) const
@@ -183,12 +388,12 @@ Rabin_automaton::find_run(const int max_threads) const
 			}
 			if (internal < rhs.internal) {
 				return true;
-			} else if (internal > rhs.internal) {
+			} else if (rhs.internal < internal) {
 				return false;
 			}
 			if (nonlive < rhs.nonlive) {
 				return true;
-			} else if (nonlive > rhs.nonlive) {
+			} else if (rhs.nonlive < nonlive) {
 				return false;
 			}
 			if (all < rhs.all) {
@@ -204,30 +409,100 @@ Rabin_automaton::find_run(const int max_threads) const
 		};
 	}; // class Run_piece
 
-	class Find_thread final
+	typedef std::list<Run_piece, Spill_allocator<Run_piece>> Piece_list;
+
+	// the pieces of a table with their states stored by column, a word of a
+	// column having a bit for each piece of its block, so that the pieces
+	// fitting under a parent are found a block at a time; the columns are the
+	// internal and nonlive states and, for every condition, whether the
+	// internal states meet its l
+	class Piece_columns final
 	{
+	public:
+		typedef bitset_t::block_type word_t;
+
 	private:
-		std::thread thread;
-		bool *done;
+		std::vector<const Run_piece *> pieces;
+		std::vector<state_t> heights;
+		std::vector<word_t> internal;
+		std::vector<word_t> nonlive;
+		std::vector<word_t> meets;
 
 	public:
-		Find_thread(std::thread &&t, bool *d) : thread{std::move(t)}, done{d} {};
+		std::size_t words;
 
-		Find_thread(const Find_thread &) = delete;
-		Find_thread(Find_thread &&) = delete;
-		Find_thread &operator=(const Find_thread &) = delete;
-		Find_thread &operator=(Find_thread &&) = delete;
+		Piece_columns() : words{0} {};
 
-		~Find_thread()
+		void build(const Piece_list &l, const state_t states, const std::list<Acceptance> &conditions)
 		{
-			thread.join();
-			delete done;
+			clear();
+			for (auto t = l.cbegin(); t != l.cend(); t++) {
+				pieces.push_back(&*t);
+				heights.push_back(t->height.load(std::memory_order_relaxed));
+			}
+			words = (pieces.size() + bitset_t::bits_per_block - 1) / bitset_t::bits_per_block;
+			internal.assign(states * words, 0);
+			nonlive.assign(states * words, 0);
+			meets.assign(conditions.size() * words, 0);
+			for (std::size_t i = 0; i < pieces.size(); i++) {
+				const Run_piece &p = *pieces[i];
+				const std::size_t w = i / bitset_t::bits_per_block;
+				const word_t bit = word_t{1} << (i % bitset_t::bits_per_block);
+				p.internal.for_each([this, w, bit](const state_t q) { internal[q * words + w] |= bit; });
+				p.nonlive.for_each([this, w, bit](const state_t q) { nonlive[q * words + w] |= bit; });
+				state_t j = 0;
+				for (auto a = conditions.cbegin(); a != conditions.cend(); a++, j++) {
+					if (p.internal.intersects(a->l)) {
+						meets[j * words + w] |= bit;
+					}
+				}
+			}
+		};
+
+		void clear()
+		{
+			words = 0;
+			pieces.clear();
+			heights.clear();
+			internal.clear();
+			nonlive.clear();
+			meets.clear();
+		};
+
+		std::size_t size() const
+		{
+			return pieces.size();
 		};
 
-		bool has_finished() { return *done; }
-	}; // class Find_thread
+		const Run_piece *piece(const std::size_t w, const word_t bit) const
+		{
+			return pieces[w * bitset_t::bits_per_block + __builtin_ctzl(bit)];
+		};
+
+		// the pieces of the block w at least h high and without p among their
+		// internal states
+		word_t below(const state_t p, const std::size_t w, const state_t h) const
+		{
+			word_t res = 0;
+			const std::size_t end = std::min(pieces.size(), (w + 1) * bitset_t::bits_per_block);
+			for (std::size_t i = w * bitset_t::bits_per_block; i < end; i++) {
+				if (heights[i] >= h) {
+					res |= word_t{1} << (i % bitset_t::bits_per_block);
+				}
+			}
+			return res & ~internal[p * words + w];
+		};
+
+		word_t live(const state_t p, const std::size_t w) const
+		{
+			return ~nonlive[p * words + w];
+		};
 
-	typedef std::list<Run_piece> Piece_list;
+		word_t avoiding(const state_t condition, const std::size_t w) const
+		{
+			return ~meets[condition * words + w];
+		};
+	}; // class Piece_columns
 
 	class Find_context final
 	{
@@ -235,225 +510,876 @@ Rabin_automaton::find_run(const int max_threads) const
 		Run &run;
 		state_t parent;
 		state_t step;
-		bitset_t tmp;
+		// the conditions whose l a piece must avoid to fit under the parent
+		std::vector<state_t> avoid;
 		Run_piece **const grafts;
-		const Piece_list *srcs;
+		const Piece_columns *srcs;
 		Piece_list *dst;
 		std::queue<const Run_piece *> lq;
 		std::queue<const Run_piece *> rq;
+		const bool collect;
+		// the runs found at the current height are saved by the main thread
+		// at its end, in order of height and state
+		const bool defer;
+		std::vector<std::tuple<state_t, state_t, Run_node *>> found;
+		Search_stats stats;
+		Height_stats *counters;
+		Trace_buffer *const trace;
 
-		Find_context(Run &r, Run_piece **const g)
-			: run{r}, parent{0}, step{0}, tmp{r.states}, grafts{g}, srcs{nullptr}, dst{nullptr} {};
+		Find_context(Run &r, Run_piece **const g, const bool c, const bool d, Trace_buffer *const b)
+			: run{r}
+			, parent{0}
+			, step{0}
+			, grafts{g}
+			, srcs{nullptr}
+			, dst{nullptr}
+			, collect{c}
+			, defer{d}
+			, counters{nullptr}
+			, trace{b} {};
 
-		void reset(const state_t q, const state_t h, const Piece_list *s, Piece_list *d)
+		void reset(const state_t q, const state_t h, const Piece_columns *s, Piece_list *d)
 		{
 			parent = q;
 			step = h;
 			srcs = s;
 			dst = d;
+			if (collect) {
+				counters = &stats.height(h);
+			}
 		};
 	}; // class Find_context
 
+	// threads kept for the whole search, each running the tasks of a phase
+	// with its own context until none is left, the calling thread takes part
+	// with the first context; a task is ready once the tasks it depends on
+	// returned
+	class Worker_pool final
+	{
+		typedef std::pair<state_t, state_t> Ranked_task;
+
+		std::vector<Find_context *> &contexts;
+		std::vector<std::thread> threads;
+		std::mutex lock;
+		std::condition_variable wake;
+		std::condition_variable more;
+		std::condition_variable idle;
+		std::function<void(Find_context &, const state_t)> task;
+		const std::vector<std::vector<state_t>> *dependents;
+		const std::vector<state_t> *ranks;
+		std::vector<state_t> waiting;
+		// the task of lowest rank, and then index, is taken first
+		std::priority_queue<Ranked_task, std::vector<Ranked_task>, std::greater<Ranked_task>> ready;
+		state_t left;
+		unsigned long phase;
+		state_t running;
+		bool stop;
+
+	public:
+		Worker_pool(std::vector<Find_context *> &c)
+			: contexts{c}, dependents{nullptr}, ranks{nullptr}, left{0}, phase{0}, running{0}, stop{false}
+		{
+			for (std::size_t i = 1; i < contexts.size(); i++) {
+				threads.emplace_back(&Worker_pool::loop, this, i);
+			}
+		};
+
+		Worker_pool(const Worker_pool &) = delete;
+		Worker_pool(Worker_pool &&) = delete;
+		Worker_pool &operator=(const Worker_pool &) = delete;
+		Worker_pool &operator=(Worker_pool &&) = delete;
+
+		~Worker_pool()
+		{
+			{
+				const std::lock_guard<std::mutex> l(lock);
+				stop = true;
+			}
+			wake.notify_all();
+			for (auto t = threads.begin(); t != threads.end(); t++) {
+				t->join();
+			}
+		};
+
+		// runs f on 0, ..., n - 1 and returns once every call returned, the
+		// call on j starts after the one on i if j is among the dependents of i,
+		// and the ready calls start in order of rank r (by default the index)
+		void run(
+			const state_t n,
+			std::function<void(Find_context &, const state_t)> f,
+			const std::vector<std::vector<state_t>> *const d = nullptr,
+			const std::vector<state_t> *const r = nullptr)
+		{
+			{
+				const std::lock_guard<std::mutex> l(lock);
+				task = std::move(f);
+				dependents = d;
+				ranks = r;
+				waiting.assign(n, 0);
+				for (state_t i = 0; nullptr != d && i < n; i++) {
+					for (auto j = (*d)[i].cbegin(); j != (*d)[i].cend(); j++) {
+						waiting[*j]++;
+					}
+				}
+				ready = decltype(ready)();
+				for (state_t i = 0; i < n; i++) {
+					if (0 == waiting[i]) {
+						push(i);
+					}
+				}
+				left = n;
+				running = threads.size();
+				phase++;
+			}
+			wake.notify_all();
+			work(*contexts.front());
+			std::unique_lock<std::mutex> l(lock);
+			idle.wait(l, [this]() { return 0 == running; });
+		};
+
+	private:
+		void push(const state_t i) { ready.emplace((nullptr != ranks) ? (*ranks)[i] : i, i); };
+
+		void work(Find_context &c)
+		{
+			std::unique_lock<std::mutex> l(lock);
+			for (;;) {
+				more.wait(l, [this]() { return !ready.empty() || 0 == left; });
+				if (ready.empty()) {
+					return;
+				}
+				const state_t i = ready.top().second;
+				ready.pop();
+				l.unlock();
+				task(c, i);
+				l.lock();
+				left--;
+				if (nullptr != dependents) {
+					for (auto j = (*dependents)[i].cbegin(); j != (*dependents)[i].cend(); j++) {
+						if (0 == --waiting[*j]) {
+							push(*j);
+							more.notify_one();
+						}
+					}
+				}
+				if (0 == left) {
+					more.notify_all();
+				}
+			}
+		};
+
+		void loop(const std::size_t i)
+		{
+			for (unsigned long seen = 0;;) {
+				{
+					std::unique_lock<std::mutex> l(lock);
+					wake.wait(l, [this, seen]() { return stop || phase != seen; });
+					if (stop) {
+						return;
+					}
+					seen = phase;
+				}
+				work(*contexts[i]);
+				const std::lock_guard<std::mutex> l(lock);
+				if (0 == --running) {
+					idle.notify_one();
+				}
+			}
+		};
+	}; // class Worker_pool
+
 	const auto inv = [](const Run_piece &v) -> bool { return v.invalid; };
 
-	const auto find_run_thread = [this](Find_context &c, bool &done) {
+	// the search stops once the starting state is nonempty, unless it looks
+	// for every nonempty state
+	const auto found = [this](const Run &r) -> bool { return !all_states && r.nonempty(starting_state); };
+
+	const auto search_state = [this, &found](Find_context &c) {
 		const auto fitting_pieces
 			= [this](
-				  const Run &run, const Run_piece *other, const state_t parent, Run_piece *graft, const Piece_list &src,
-				  std::queue<const Run_piece *> &out, const state_t h, bitset_t &tmp) {
+				  const Run &run, const Run_piece *other, const state_t parent, Run_piece *graft,
+				  const Piece_columns &src, std::queue<const Run_piece *> &out, const state_t h,
+				  std::vector<state_t> &avoid, Height_stats *const hs) {
 				  for (; !out.empty(); out.pop()) {
 				  }
 				  if (run.nonempty(graft->state) || (0 != other->height && other->all.test(graft->state))) {
 					  if (graft->height >= h) {
 						  out.push(graft);
+						  STATS_ADD(hs, accepted, 1);
 					  }
 					  return;
 				  }
-				  for (auto t = src.cbegin(); t != src.cend(); t++) {
-					  if (t->height < h || t->internal.test(parent)) {
-						  continue;
+				  STATS_ADD(hs, scanned, src.size());
+				  // a piece fits if neither it nor other leave parent nonlive,
+				  // or if the internal states of both avoid the l of a
+				  // condition with parent in u
+				  const bool live = !other->nonlive.test(parent);
+				  avoid.clear();
+				  state_t j = 0;
+				  for (auto a = conditions.cbegin(); a != conditions.cend(); a++, j++) {
+					  if (a->u.test(parent) && !other->internal.intersects(a->l)) {
+						  avoid.push_back(j);
 					  }
-					  if (!other->nonlive.test(parent) && !t->nonlive.test(parent)) {
-						  out.push(&*t);
-						  continue;
+				  }
+				  for (std::size_t w = 0; w < src.words; w++) {
+					  Piece_columns::word_t fit = live ? src.live(parent, w) : 0;
+					  for (auto a = avoid.cbegin(); a != avoid.cend(); a++) {
+						  fit |= src.avoiding(*a, w);
 					  }
-					  tmp.reset();
-					  tmp |= other->internal;
-					  tmp |= t->internal;
-					  tmp.set(parent);
-					  for (auto a = conditions.cbegin(); a != conditions.cend(); a++) {
-						  if (a->u.test(parent) && !tmp.intersects(a->l)) {
-							  out.push(&*t);
-							  break;
-						  }
+					  for (fit &= src.below(parent, w, h); 0 != fit; fit &= fit - 1) {
+						  out.push(src.piece(w, fit));
+						  STATS_ADD(hs, accepted, 1);
 					  }
 				  }
 			  }; // fitting_pieces
-		// start of find_run_thread
+		// start of search_state
 		if (c.run.nonempty(c.parent)) {
-			done = true;
 			return;
 		}
 		const state_t &s = c.parent;
 		const state_t &h = c.step;
 		const Run_piece *const wild_card = *c.grafts;
 		for (auto t = transitions[s].cbegin(); t != transitions[s].cend(); t++) {
-			if (c.run.nonempty(starting_state)) {
-				done = true;
+			// s is possibly made nonempty by the piece of another worker
+			if (found(c.run) || c.run.nonempty(s)) {
 				return;
 			}
-			fitting_pieces(c.run, wild_card, s, c.grafts[t->left], c.srcs[t->left], c.lq, 0, c.tmp);
-			for (const Run_piece *left; !c.lq.empty() && !c.run.nonempty(starting_state); c.lq.pop()) {
+			fitting_pieces(c.run, wild_card, s, c.grafts[t->left], c.srcs[t->left], c.lq, 0, c.avoid, c.counters);
+			for (const Run_piece *left; !c.lq.empty() && !found(c.run); c.lq.pop()) {
 				left = c.lq.front();
 				fitting_pieces(
-					c.run, left, s, c.grafts[t->right], c.srcs[t->right], c.rq, (left->height == h) ? 0 : h, c.tmp);
-				for (const Run_piece *right; !c.rq.empty() && !c.run.nonempty(starting_state); c.rq.pop()) {
+					c.run,
+					left,
+					s,
+					c.grafts[t->right],
+					c.srcs[t->right],
+					c.rq,
+					(left->height == h) ? 0 : h,
+					c.avoid,
+					c.counters);
+				for (const Run_piece *right; !c.rq.empty() && !found(c.run); c.rq.pop()) {
 					right = c.rq.front();
 					c.dst->emplace_back(s, left, right);
-					if (c.dst->back().graft) {
-						c.grafts[s]->height = c.dst->back().height;
+					STATS_ADD(c.counters, generated, 1);
+					const Run_piece &p = c.dst->back();
+					if (p.nonlive.none()) {
+						if (c.defer) {
+							c.found.emplace_back(p.height.load(), s, p.node());
+						} else {
+							c.run.save_subruns(p.node());
+							c.grafts[s]->height = p.height.load();
+						}
 						c.dst->pop_back();
-						done = true;
 						return;
 					}
 				}
 			}
 		}
-		if (!c.run.nonempty(starting_state)) {
-			c.dst->sort();
+		if (!found(c.run)) {
+			if (c.collect) {
+				const search_clock::time_point start = search_clock::now();
+				c.dst->sort();
+				c.stats.phase_time[PHASE_SORT] += search_clock::now() - start;
+			} else {
+				c.dst->sort();
+			}
+		}
+	}; // search_state
+
+	const auto find_run_thread = [&search_state](Find_context &c) {
+		Trace_buffer::local = c.trace;
+		if (nullptr != c.trace) {
+			c.trace->height = c.step;
+		}
+		{
+			const Trace_span span(c.trace, "search_state", c.step, c.parent);
+			search_state(c);
 		}
-		done = true;
+		Trace_buffer::local = nullptr;
 	}; // find_run_thread
 
-	// start of Rabin_automaton::find_run
-	if (1 > max_threads) {
-		throw std::invalid_argument("invalid max_threads (is less than 1)");
-	}
+	// start of Rabin_automaton::search
 	if (!has_transitions || conditions.empty()) {
+		delete seed;
 		return nullptr;
 	}
-	Run *res = new Run(states, starting_state);
+	const State_orbits orbits = find_orbits();
+	if (nullptr != stats) {
+		stats->orbits = orbits.reps.size();
+	}
+	// a checkpoint is the canonical representation of the automaton, the
+	// height to search next, the run found so far, the heights of the grafts
+	// and the tables, a piece per line with its height, the blocks of its
+	// internal, nonlive and all states, and its left, right and base pieces,
+	// each - if missing, g and a state for a graft or p and the index of a
+	// piece in the tables
+	std::string rep;
+	if (nullptr != checkpoint || nullptr != resume) {
+		std::ostringstream os;
+		print_canonical_rep(os);
+		rep = os.str();
+	}
+	std::ifstream is;
+	state_t first = 0;
+	Run *res = nullptr;
+	if (nullptr != resume) {
+		delete seed;
+		is.open(resume);
+		std::string stored(rep.size(), '\0');
+		std::string word;
+		if (is.read(&stored[0], stored.size()) && stored == rep && is >> word >> first && "height" == word
+			&& first < states) {
+			res = Run::deserialize(is, states, starting_state, true);
+		}
+		if (nullptr == res) {
+			throw std::runtime_error(std::string("no checkpoint of the automaton in ") + resume);
+		}
+	} else if (nullptr != seed) {
+		res = seed;
+	} else {
+		res = new Run(states, starting_state);
+	}
 	Run &run = *res;
 	Piece_list *src = new Piece_list[states];
 	Piece_list *dst = new Piece_list[states];
+	Piece_columns *src_cols = new Piece_columns[states];
+	Piece_columns *dst_cols = new Piece_columns[states];
 	Run_piece **grafts = new Run_piece *[states];
 	for (state_t s = 0; s < states; s++) {
 		grafts[s] = new Run_piece(run, s, true);
-		for (auto a = conditions.cbegin(); a != conditions.cend(); a++) {
+		for (auto a = conditions.cbegin(); nullptr == resume && a != conditions.cend(); a++) {
 			if (a->u.test(s) && !a->l.test(s)) {
 				src[s].emplace_back(run, s);
 			}
 		}
 	}
-
-	const state_t max_workers
-		= (states < static_cast<unsigned int>(max_threads - 1)) ? states : static_cast<state_t>(max_threads - 1);
-	std::queue<Find_context *> ctx_pool;
-	{
-		state_t i = 0;
-		do {
-			ctx_pool.push(new Find_context(run, grafts));
-		} while (++i < max_workers);
-	}
-	std::list<std::pair<Find_thread, Find_context *>> workers;
-	for (state_t h = 0; h < states; h++, std::swap(src, dst)) {
-
-		if (1 == max_threads) {
-			Find_context *c = ctx_pool.front();
-			bool d;
-			for (state_t s = 0; s < states; s++) {
-				c->reset(s, h, src, &dst[s]);
-				find_run_thread(*c, d);
-				if (run.nonempty(starting_state)) {
-					break;
+	const std::size_t blocks = (states + bitset_t::bits_per_block - 1) / bitset_t::bits_per_block;
+	const auto read_bits = [this, &is, blocks](State_set &b) -> bool {
+		std::vector<bitset_t::block_type> v(blocks);
+		for (auto x = v.begin(); x != v.end(); x++) {
+			if (!(is >> std::hex >> *x >> std::dec)) {
+				return false;
+			}
+		}
+		// the bits past the states must be clear
+		if (0 != states % bitset_t::bits_per_block && 0 != (v.back() >> (states % bitset_t::bits_per_block))) {
+			return false;
+		}
+		b = State_set(states);
+		for (std::size_t i = 0; i < v.size(); i++) {
+			for (bitset_t::block_type x = v[i]; 0 != x; x &= x - 1) {
+				b.set(i * bitset_t::bits_per_block + __builtin_ctzl(x));
+			}
+		}
+		return true;
+	};
+	const auto read_tables = [&]() -> bool {
+		std::string word;
+		if (!(is >> word) || "heights" != word) {
+			return false;
+		}
+		for (state_t s = 0; s < states; s++) {
+			state_t h = 0;
+			if (!(is >> h)) {
+				return false;
+			}
+			grafts[s]->height = h;
+		}
+		std::vector<Run_piece *> pieces;
+		std::vector<std::pair<char, std::size_t>> refs;
+		for (state_t q = 0; q < states; q++) {
+			std::size_t n = 0;
+			if (!(is >> word >> n) || "table" != word) {
+				return false;
+			}
+			for (std::size_t i = 0; i < n; i++) {
+				state_t h = 0;
+				if (!(is >> h)) {
+					return false;
+				}
+				src[q].emplace_back(run, q, false, h);
+				Run_piece &p = src[q].back();
+				if (!read_bits(p.internal) || !read_bits(p.nonlive) || !read_bits(p.all)) {
+					return false;
+				}
+				pieces.push_back(&p);
+				for (int j = 0; j < 3; j++) {
+					char kind = '\0';
+					std::size_t k = 0;
+					if (!(is >> kind) || ('-' != kind && !(is >> k))) {
+						return false;
+					}
+					refs.emplace_back(kind, k);
 				}
 			}
+		}
+		std::vector<const Run_piece *> linked(3);
+		for (std::size_t i = 0; i < pieces.size(); i++) {
+			for (int j = 0; j < 3; j++) {
+				const std::pair<char, std::size_t> &r = refs[3 * i + j];
+				if ('-' == r.first) {
+					linked[j] = nullptr;
+				} else if ('g' == r.first && r.second < states) {
+					linked[j] = grafts[r.second];
+				} else if ('p' == r.first && r.second < pieces.size()) {
+					linked[j] = pieces[r.second];
+				} else {
+					return false;
+				}
+			}
+			// the images must follow the orbits of this search, that the -S
+			// option may have changed since the checkpoint
+			const state_t q = pieces[i]->state;
+			if ((nullptr == linked[0]) != (nullptr == linked[1])
+				|| (nullptr != linked[2] && (orbits.is_rep(q) || orbits.rep[q] != linked[2]->state))) {
+				return false;
+			}
+			pieces[i]->link(
+				linked[0], linked[1], linked[2], (nullptr != linked[2]) ? &orbits.to[pieces[i]->state] : nullptr);
+		}
+		return true;
+	};
+	if (nullptr != resume && !read_tables()) {
+		for (state_t s = 0; s < states; s++) {
+			delete grafts[s];
+		}
+		delete[] grafts;
+		delete[] src;
+		delete[] dst;
+		delete[] src_cols;
+		delete[] dst_cols;
+		delete res;
+		throw std::runtime_error(std::string("malformed checkpoint in ") + resume);
+	}
+	for (state_t s = 0; s < states; s++) {
+		src_cols[s].build(src[s], states, conditions);
+	}
+	// the file is written aside and renamed, so that a search stopped while
+	// writing it can still resume from the previous one
+	const auto write_checkpoint = [&](const state_t next) -> bool {
+		std::unordered_map<const Run_piece *, std::size_t> ids;
+		for (state_t q = 0; q < states; q++) {
+			for (auto t = dst[q].cbegin(); t != dst[q].cend(); t++) {
+				ids.emplace(&*t, ids.size());
+			}
+		}
+		const std::string tmp = std::string(checkpoint) + '.' + std::to_string(getpid());
+		std::ofstream os(tmp);
+		std::vector<bitset_t::block_type> v(blocks);
+		const auto write_bits = [&os, &v](const State_set &b) {
+			std::fill(v.begin(), v.end(), 0);
+			b.for_each([&v](const state_t q) {
+				v[q / bitset_t::bits_per_block] |= bitset_t::block_type{1} << (q % bitset_t::bits_per_block);
+			});
+			for (auto x = v.cbegin(); x != v.cend(); x++) {
+				os << ' ' << std::hex << *x << std::dec;
+			}
+		};
+		bool ok = true;
+		const auto write_ref = [&os, &ids, &ok](const Run_piece *const p) {
+			if (nullptr == p) {
+				os << " -";
+			} else if (p->graft) {
+				os << " g " << p->state;
+			} else {
+				const auto i = ids.find(p);
+				ok = ok && ids.end() != i;
+				os << " p " << ((ids.end() != i) ? i->second : 0);
+			}
+		};
+		os << rep << "height " << next << std::endl;
+		run.serialize(os);
+		os << "heights";
+		for (state_t s = 0; s < states; s++) {
+			os << ' ' << grafts[s]->height.load();
+		}
+		os << std::endl;
+		for (state_t q = 0; q < states; q++) {
+			os << "table " << dst[q].size() << std::endl;
+			for (auto t = dst[q].cbegin(); t != dst[q].cend(); t++) {
+				os << t->height.load();
+				write_bits(t->internal);
+				write_bits(t->nonlive);
+				write_bits(t->all);
+				write_ref(t->left_piece());
+				write_ref(t->right_piece());
+				write_ref(t->base_piece());
+				os << std::endl;
+			}
+		}
+		os.close();
+		if (!os || !ok || 0 != rename(tmp.c_str(), checkpoint)) {
+			const int e = errno;
+			unlink(tmp.c_str());
+			errno = ok ? e : EINVAL;
+			return false;
+		}
+		return true;
+	};
+	if (nullptr != progress) {
+		counter_t pieces = 0;
+		for (state_t s = 0; s < states; s++) {
+			pieces += src[s].size();
+		}
+		progress->height = first;
+		progress->pieces = pieces;
+		progress->generated = 0;
+		progress->total = 0;
+		progress->nonempty = 0;
+		progress->states = states;
+	}
 
-		} else {
-
-			state_t s = 0;
-			for (; s < max_workers; s++) {
-				bool *done = new bool{false};
-				Find_context *c = ctx_pool.front();
-				ctx_pool.pop();
-				c->reset(s, h, src, &dst[s]);
-				workers.emplace_back(
-					std::piecewise_construct,
-					std::forward_as_tuple(std::thread(find_run_thread, std::ref(*c), std::ref(*done)), done),
-					std::forward_as_tuple(c));
+	Trace_buffer *const main_trace = (nullptr != trace) ? trace->buffer("main") : nullptr;
+	const std::vector<state_t> &reps = orbits.reps;
+	const state_t max_workers
+		= (states < static_cast<unsigned int>(max_threads)) ? states : static_cast<state_t>(max_threads);
+	std::vector<Find_context *> contexts;
+	for (state_t i = 0; i < max_workers; i++) {
+		contexts.push_back(new Find_context(
+			run, grafts, nullptr != stats, deterministic, (nullptr != trace) ? trace->buffer("worker") : nullptr));
+	}
+	Worker_pool pool(contexts);
+	// the tasks of a height are the generation of the pieces of every
+	// representative, the images of its pieces for the other states of its
+	// orbit, and the merge of the table of every state, that waits only for
+	// the tasks reading or writing that table instead of the whole height
+	const state_t image_task = reps.size();
+	const state_t merge_task = image_task + states;
+	std::vector<std::vector<state_t>> dependents(merge_task + states);
+	for (state_t i = 0; i < reps.size(); i++) {
+		const state_t r = reps[i];
+		const std::vector<state_t> &m = orbits.members[r];
+		for (auto q = m.cbegin(); q != m.cend(); q++) {
+			if (*q != r) {
+				dependents[i].push_back(image_task + *q);
+				dependents[image_task + *q].push_back(merge_task + *q);
+				dependents[image_task + *q].push_back(merge_task + r);
 			}
-			for (;;) {
-				if (run.nonempty(starting_state) || workers.empty()) {
-					for (auto t = workers.begin(); t != workers.end(); t++) {
-						ctx_pool.push(t->second);
-						t = workers.erase(t);
-						t--;
+		}
+		dependents[i].push_back(merge_task + r);
+		for (auto t = transitions[r].cbegin(); t != transitions[r].cend(); t++) {
+			dependents[i].push_back(merge_task + t->left);
+			dependents[i].push_back(merge_task + t->right);
+		}
+		std::sort(dependents[i].begin(), dependents[i].end());
+		dependents[i].erase(std::unique(dependents[i].begin(), dependents[i].end()), dependents[i].end());
+	}
+	// the tasks of a state are ranked by its distance from the starting
+	// state, whose emptiness alone stops the search, and then by the fewest
+	// nonlive states of a piece of its table, the closest to a run; the
+	// representative of an orbit generates for its nearest member
+	std::vector<state_t> distance(states, all_states ? 0 : STATE_MAX);
+	if (!all_states) {
+		std::queue<state_t> visit;
+		distance[starting_state] = 0;
+		for (visit.push(starting_state); !visit.empty(); visit.pop()) {
+			const state_t p = visit.front();
+			for (auto t = transitions[p].cbegin(); t != transitions[p].cend(); t++) {
+				for (const state_t q : {t->left, t->right}) {
+					if (STATE_MAX == distance[q]) {
+						distance[q] = distance[p] + 1;
+						visit.push(q);
 					}
-					break;
 				}
-				for (auto t = workers.begin(); t != workers.end(); t++) {
-					if (t->first.has_finished()) {
-						ctx_pool.push(t->second);
-						t = workers.erase(t);
-						t--;
-						for (; s < states && (run.nonempty(starting_state) || run.nonempty(s)); s++) {
+			}
+		}
+		for (state_t q = 0; q < states; q++) {
+			distance[orbits.rep[q]] = std::min(distance[orbits.rep[q]], distance[q]);
+		}
+	}
+	std::vector<state_t> closest(states, STATE_MAX);
+	const auto closest_piece = [&closest](const state_t q, const Piece_list &l) {
+		closest[q] = STATE_MAX;
+		for (auto t = l.cbegin(); t != l.cend(); t++) {
+			closest[q] = std::min(closest[q], t->nonlive.size());
+		}
+	};
+	for (state_t q = 0; q < states; q++) {
+		closest_piece(q, src[q]);
+	}
+	std::vector<state_t> order(states);
+	std::vector<state_t> task_rank(merge_task + states);
+	const auto rank_tasks = [&]() {
+		for (state_t q = 0; q < states; q++) {
+			order[q] = q;
+		}
+		std::sort(order.begin(), order.end(), [&distance, &closest](const state_t x, const state_t y) {
+			return std::tie(distance[x], closest[x], x) < std::tie(distance[y], closest[y], y);
+		});
+		for (state_t i = 0; i < states; i++) {
+			task_rank[image_task + order[i]] = i;
+			task_rank[merge_task + order[i]] = i;
+		}
+		for (state_t i = 0; i < reps.size(); i++) {
+			task_rank[i] = task_rank[merge_task + reps[i]];
+		}
+	};
+	// whether the merge of a state found it nonempty
+	std::vector<char> merged_nonempty(states);
+	search_clock::time_point mark = search_clock::now();
+	const auto lap = [stats, main_trace, &mark](const Search_phase p) {
+		if (nullptr != stats || nullptr != main_trace) {
+			const search_clock::time_point now = search_clock::now();
+			if (nullptr != stats) {
+				stats->phase_time[p] += now - mark;
+			}
+			if (nullptr != main_trace) {
+				main_trace->span(phase_name[p], mark, main_trace->height, STATE_MAX);
+			}
+			mark = now;
+		}
+	};
+#ifndef NO_SEARCH_STATS
+	const auto table_bytes = [this](const Piece_list *const l) -> counter_t {
+		counter_t res = 0;
+		for (state_t q = 0; q < states; q++) {
+			for (auto t = l[q].cbegin(); t != l[q].cend(); t++) {
+				res += sizeof(Run_piece) + 2 * sizeof(void *) + t->internal.bytes() + t->nonlive.bytes()
+					   + t->all.bytes();
+			}
+		}
+		return res;
+	};
+#endif
+	const auto close_height = [this, &run, &mark](Height_stats *const hs, const search_clock::time_point start) {
+		if (nullptr != hs) {
+			for (state_t q = 0; q < states; q++) {
+				if (run.nonempty(q)) {
+					hs->nonempty++;
+				}
+			}
+			hs->time = mark - start;
+		}
+	};
+	// the states still empty at the end of the last height
+	state_t empty = states;
+	for (state_t q = 0; q < states; q++) {
+		empty -= run.nonempty(q) ? 1 : 0;
+	}
+	// whether the graft or a piece of the table of a state is higher than
+	// the last height
+	std::vector<char> fresh(states);
+	search_clock::time_point saved = search_clock::now();
+	for (state_t h = first; h < states; h++, std::swap(src, dst), std::swap(src_cols, dst_cols)) {
+		Height_stats *hs = nullptr;
+		const search_clock::time_point height_start = mark;
+		if (nullptr != stats) {
+			stats->heights = h + 1;
+			hs = &stats->height(h);
+		}
+		if (nullptr != main_trace) {
+			main_trace->height = h;
+		}
+		if (nullptr != progress) {
+			progress->generated.store(0, std::memory_order_relaxed);
+			progress->height = h;
+		}
+
+		rank_tasks();
+		pool.run(
+			merge_task + states,
+			[&](Find_context &c, const state_t i) {
+				if (found(run)) {
+					return;
+				}
+				if (i < image_task) {
+					if (!run.nonempty(reps[i])) {
+						c.reset(reps[i], h, src_cols, &dst[reps[i]]);
+						find_run_thread(c);
+						if (nullptr != progress) {
+							progress->add(dst[reps[i]].size());
 						}
-						if (s < states) {
-							bool *done = new bool{false};
-							Find_context *c = ctx_pool.front();
-							ctx_pool.pop();
-							c->reset(s, h, src, &dst[s]);
-							workers.emplace_back(
-								std::piecewise_construct,
-								std::forward_as_tuple(
-									std::thread(find_run_thread, std::ref(*c), std::ref(*done)), done),
-								std::forward_as_tuple(c));
-							s++;
+					}
+					return;
+				}
+				if (i < merge_task) {
+					const state_t q = i - image_task;
+					if (!orbits.is_rep(q)) {
+						const state_t r = orbits.rep[q];
+						for (auto t = dst[r].cbegin(); t != dst[r].cend(); t++) {
+							dst[q].emplace_back(*t, orbits.to[q]);
 						}
 					}
+					return;
 				}
-				std::this_thread::sleep_for(std::chrono::milliseconds(2));
+				const state_t q = i - merge_task;
+				const Trace_span span(c.trace, "merge", h, q);
+				c.reset(q, h, src_cols, &dst[q]);
+				// every generation reading the table of q returned
+				src_cols[q].clear();
+				merged_nonempty[q] = run.nonempty(q);
+				// only the tables of the representatives are sorted and
+				// deduplicated, the images follow the validity of their pieces
+				if (orbits.is_rep(q)) {
+					dst[q].merge(src[q]);
+				} else {
+					dst[q].splice(dst[q].end(), src[q]);
+					if (!merged_nonempty[q]) {
+						return;
+					}
+				}
+				for (auto t = dst[q].begin(); t != dst[q].end(); t++) {
+					if (merged_nonempty[q]) {
+						t->invalid.store(true, std::memory_order_relaxed);
+						STATS_ADD(c.counters, invalidated, 1);
+					} else if (t != dst[q].begin() && Run_piece::similar(*t, *std::prev(t))) {
+						t->invalid.store(true, std::memory_order_relaxed);
+						STATS_ADD(c.counters, deduplicated, 1);
+					}
+				}
+			},
+			&dependents,
+			&task_rank);
+		if (deterministic) {
+			typedef std::tuple<state_t, state_t, Run_node *> Found_run;
+			std::vector<Found_run> found;
+			for (auto c = contexts.cbegin(); c != contexts.cend(); c++) {
+				found.insert(found.end(), (*c)->found.cbegin(), (*c)->found.cend());
+				(*c)->found.clear();
+			}
+			// a state has at most a run per height
+			std::sort(found.begin(), found.end(), [](const Found_run &x, const Found_run &y) {
+				return std::get<0>(x) < std::get<0>(y)
+					   || (std::get<0>(x) == std::get<0>(y) && std::get<1>(x) < std::get<1>(y));
+			});
+			Trace_buffer::local = main_trace;
+			for (auto f = found.cbegin(); f != found.cend(); f++) {
+				run.save_subruns(std::get<2>(*f));
+				grafts[std::get<1>(*f)]->height = std::get<0>(*f);
+			}
+			Trace_buffer::local = nullptr;
+		}
+		lap(PHASE_GENERATION);
+#ifndef NO_SEARCH_STATS
+		if (nullptr != stats) {
+			const counter_t bytes = table_bytes(src) + table_bytes(dst);
+			if (stats->peak_piece_bytes < bytes) {
+				stats->peak_piece_bytes = bytes;
 			}
-		} // found new Run_pieces
+		}
+#endif
 
-		if (run.nonempty(starting_state)) {
+		// the states of an orbit are all nonempty or all empty, once every
+		// graft their images depend on is saved
+		for (bool saved = reps.size() < states; saved;) {
+			saved = false;
+			for (state_t q = 0; q < states; q++) {
+				const std::vector<state_t> &m = orbits.members[orbits.rep[q]];
+				for (auto x = m.cbegin(); x != m.cend() && !run.nonempty(q); x++) {
+					if (run.nonempty(*x) && run.save_image(*x, orbits.mapping(*x, q))) {
+						grafts[q]->height = grafts[*x]->height.load();
+						saved = true;
+					}
+				}
+			}
+		}
+		const state_t was_empty = empty;
+		empty = states;
+		for (state_t q = 0; q < states; q++) {
+			empty -= run.nonempty(q) ? 1 : 0;
+		}
+		if (found(run) || (all_states && 0 == empty)) {
+			close_height(hs, height_start);
 			break;
 		}
+		// the states made nonempty after their merge
 		for (state_t q = 0; q < states; q++) {
 			if (run.nonempty(q) && (0 == grafts[q]->height)) {
 				grafts[q]->height = h + 1;
 			}
-
-			dst[q].merge(src[q]);
-			for (auto t = dst[q].begin(); t != dst[q].end(); t++) {
-				if (run.nonempty(q) || (t != dst[q].begin() && Run_piece::similar(*t, *std::prev(t)))) {
-					t->invalid = true;
+			for (auto t = dst[q].begin(); run.nonempty(q) && !merged_nonempty[q] && t != dst[q].end(); t++) {
+				if (!t->invalid.load(std::memory_order_relaxed)) {
+					t->invalid.store(true, std::memory_order_relaxed);
+					STATS_ADD(hs, invalidated, 1);
 				}
 			}
 		}
-		bool invalidated = false;
+		lap(PHASE_MERGE);
+		// the rounds are separated by the end of the phases of the pool, so a
+		// round missing a piece invalidated concurrently is followed by another
+		std::atomic<bool> invalidated{false};
 		do {
 			invalidated = false;
-			for (state_t q = 0; q < states; q++) {
+			pool.run(states, [&](Find_context &c, const state_t q) {
+				c.reset(q, h, src_cols, &dst[q]);
 				for (auto t = dst[q].begin(); t != dst[q].end(); t++) {
-					if (t->invalid_child() && !t->invalid) {
-						t->invalid = true;
-						invalidated = true;
+					if (!t->invalid.load(std::memory_order_relaxed) && t->invalid_child()) {
+						t->invalid.store(true, std::memory_order_relaxed);
+						invalidated.store(true, std::memory_order_relaxed);
+						STATS_ADD(c.counters, invalidated, 1);
 					}
 				}
-			}
+			});
 		} while (invalidated);
-		for (state_t q = 0; q < states; q++) {
+		lap(PHASE_INVALIDATION);
+		pool.run(states, [&](Find_context &, const state_t q) {
 			dst[q].remove_if(inv);
+			dst_cols[q].build(dst[q], states, conditions);
+			fresh[q] = h < grafts[q]->height
+					   || std::any_of(dst[q].cbegin(), dst[q].cend(), [h](const Run_piece &p) { return h < p.height; });
+			closest_piece(q, dst[q]);
+		});
+		lap(PHASE_REMOVAL);
+#ifndef NO_SEARCH_STATS
+		if (nullptr != hs) {
+			for (state_t q = 0; q < states; q++) {
+				hs->pieces += dst[q].size();
+				if (hs->max_state_pieces < dst[q].size()) {
+					hs->max_state_pieces = dst[q].size();
+					hs->max_state = q;
+				}
+			}
 		}
+#endif
+		if (nullptr != progress) {
+			counter_t pieces = 0;
+			state_t nonempty = 0;
+			for (state_t q = 0; q < states; q++) {
+				pieces += dst[q].size();
+				nonempty += run.nonempty(q) ? 1 : 0;
+			}
+			progress->pieces = pieces;
+			progress->nonempty = nonempty;
+		}
+		// every piece of the next heights needs a child at least as high,
+		// without any the tables and the nonempty states are at a fixpoint
+		if (was_empty == empty && std::find(fresh.cbegin(), fresh.cend(), 1) == fresh.cend()) {
+			if (nullptr != stats) {
+				stats->fixpoint = true;
+			}
+			close_height(hs, height_start);
+			break;
+		}
+		if (nullptr != checkpoint && h + 1 < states
+			&& ((0 < checkpoint_seconds) ? std::chrono::seconds(checkpoint_seconds) <= search_clock::now() - saved
+										 : 0 == (h + 1 - first) % checkpoint_heights)) {
+			if (!write_checkpoint(h + 1)) {
+				std::cerr << "could not write the checkpoint file " << checkpoint << ": " << strerror(errno)
+						  << std::endl;
+			}
+			saved = search_clock::now();
+		}
+		close_height(hs, height_start);
+		Spill_store::end_layer();
 	}
 
-	if (!run.nonempty(starting_state)) {
+	if (nullptr != stats) {
+		stats->run_node_bytes = run.size() * sizeof(Run_node);
+		stats->spilled_bytes = Spill_store::spilled_bytes();
+	}
+	bool nonempty = run.nonempty(starting_state);
+	for (state_t q = 0; all_states && !nonempty && q < states; q++) {
+		nonempty = run.nonempty(q);
+	}
+	if (!nonempty) {
 		delete res;
 		res = nullptr;
 	}
-	for (; !ctx_pool.empty(); ctx_pool.pop()) {
-		delete ctx_pool.front();
+	for (auto c = contexts.cbegin(); c != contexts.cend(); c++) {
+		if (nullptr != stats) {
+			stats->merge((*c)->stats);
+		}
+		delete *c;
 	}
 	for (state_t s = 0; s < states; s++) {
 		delete grafts[s];
@@ -461,6 +1387,8 @@ Rabin_automaton::find_run(const int max_threads) const
 	delete[] grafts;
 	delete[] src;
 	delete[] dst;
+	delete[] src_cols;
+	delete[] dst_cols;
 	return res;
 }
 
@@ -485,26 +1413,121 @@ Rabin_automaton::print_logic_prog_rep(std::ostream &os) const
 	return acceptances_print_logic_prog_rep(os);
 }
 
+// the Rabin pairs as l/2 and u/2 facts, the Streett pairs as e/2 and f/2
+// facts after a streett fact and the Muller sets as m/2 facts after a muller
+// fact
 std::ostream &
 Rabin_automaton::acceptances_print_logic_prog_rep(std::ostream &os) const
 {
+	const bool streett = ACCEPTANCE_STREETT == kind;
+	if (ACCEPTANCE_RABIN != kind) {
+		os << (streett ? "streett." : "muller.") << std::endl;
+	}
+	const std::list<Acceptance> &list = streett ? streett_pairs : conditions;
 	std::list<Acceptance>::size_type idx = 0;
-	for (auto a = conditions.cbegin(); a != conditions.cend(); a++, idx++) {
+	for (auto a = list.cbegin(); a != list.cend(); a++, idx++) {
 		auto state = a->l.find_first();
 		while (a->l.npos != state) {
-			os << "l(" << idx << ',' << state << "). ";
+			os << (streett ? "e(" : "l(") << idx << ',' << state << "). ";
 			state = a->l.find_next(state);
 		}
 		os << std::endl;
 		state = a->u.find_first();
 		while (a->u.npos != state) {
-			os << "u(" << idx << ',' << state << "). ";
+			os << (streett ? "f(" : "u(") << idx << ',' << state << "). ";
 			state = a->u.find_next(state);
 		}
-		if (conditions.cend() != std::next(a)) {
+		if (list.cend() != std::next(a)) {
 			os << std::endl;
 		}
 	}
+	idx = 0;
+	for (auto m = muller_sets.cbegin(); m != muller_sets.cend(); m++, idx++) {
+		for (auto q = m->find_first(); m->npos != q; q = m->find_next(q)) {
+			os << "m(" << idx << ',' << q << "). ";
+		}
+		if (muller_sets.cend() != std::next(m)) {
+			os << std::endl;
+		}
+	}
+	return os;
+}
+
+// the automaton with sorted transitions and acceptance conditions and without
+// duplicates, so that automata differing only in their order have the same
+// representation
+std::ostream &
+Rabin_automaton::print_canonical_rep(std::ostream &os) const
+{
+	os << "states " << states << std::endl;
+	os << "start " << starting_state << std::endl;
+	for (state_t q = 0; q < states; q++) {
+		std::vector<std::pair<state_t, state_t>> succ;
+		for (auto t = transitions[q].cbegin(); t != transitions[q].cend(); t++) {
+			succ.emplace_back(t->left, t->right);
+		}
+		std::sort(succ.begin(), succ.end());
+		succ.erase(std::unique(succ.begin(), succ.end()), succ.end());
+		for (auto t = succ.cbegin(); t != succ.cend(); t++) {
+			os << "transition " << q << ' ' << t->first << ' ' << t->second << std::endl;
+		}
+	}
+	if (ACCEPTANCE_RABIN != kind) {
+		os << "kind " << ((ACCEPTANCE_STREETT == kind) ? "streett" : "muller") << std::endl;
+	}
+	const std::list<Acceptance> &list = (ACCEPTANCE_STREETT == kind) ? streett_pairs : conditions;
+	std::vector<std::pair<std::vector<state_t>, std::vector<state_t>>> pairs;
+	for (auto a = list.cbegin(); a != list.cend(); a++) {
+		pairs.emplace_back();
+		for (auto q = a->l.find_first(); a->l.npos != q; q = a->l.find_next(q)) {
+			pairs.back().first.push_back(q);
+		}
+		for (auto q = a->u.find_first(); a->u.npos != q; q = a->u.find_next(q)) {
+			pairs.back().second.push_back(q);
+		}
+	}
+	std::sort(pairs.begin(), pairs.end());
+	pairs.erase(std::unique(pairs.begin(), pairs.end()), pairs.end());
+	for (auto a = pairs.cbegin(); a != pairs.cend(); a++) {
+		os << ((ACCEPTANCE_STREETT == kind) ? "streett" : "acceptance");
+		for (auto q = a->first.cbegin(); q != a->first.cend(); q++) {
+			os << ' ' << *q;
+		}
+		os << " ,";
+		for (auto q = a->second.cbegin(); q != a->second.cend(); q++) {
+			os << ' ' << *q;
+		}
+		os << std::endl;
+	}
+	std::vector<std::vector<state_t>> sets;
+	for (auto m = muller_sets.cbegin(); m != muller_sets.cend(); m++) {
+		sets.emplace_back();
+		for (auto q = m->find_first(); m->npos != q; q = m->find_next(q)) {
+			sets.back().push_back(q);
+		}
+	}
+	std::sort(sets.begin(), sets.end());
+	sets.erase(std::unique(sets.begin(), sets.end()), sets.end());
+	for (auto m = sets.cbegin(); m != sets.cend(); m++) {
+		os << "muller";
+		for (auto q = m->cbegin(); q != m->cend(); q++) {
+			os << ' ' << *q;
+		}
+		os << std::endl;
+	}
+	return os;
+}
+
+// the states of s followed by a space, or none
+static std::ostream &
+print_set(std::ostream &os, const bitset_t &s)
+{
+	if (s.none()) {
+		return os << "none ";
+	}
+	for (auto q = s.find_first(); s.npos != q; q = s.find_next(q)) {
+		os << q << ' ';
+	}
 	return os;
 }
 
@@ -538,30 +1561,31 @@ operator<<(std::ostream &os, const Rabin_automaton &automaton)
 			}
 		}
 	}
+	if (!automaton.streett_pairs.empty()) {
+		os << "streett :=" << std::endl;
+		for (auto a = automaton.streett_pairs.cbegin(); a != automaton.streett_pairs.cend(); a++) {
+			os << '\t' << *a;
+			if (automaton.streett_pairs.cend() != std::next(a)) {
+				os << std::endl;
+			}
+		}
+	}
+	if (!automaton.muller_sets.empty()) {
+		os << "muller :=" << std::endl;
+		for (auto m = automaton.muller_sets.cbegin(); m != automaton.muller_sets.cend(); m++) {
+			print_set(os << "\t( ", *m) << ')';
+			if (automaton.muller_sets.cend() != std::next(m)) {
+				os << std::endl;
+			}
+		}
+	}
 	return os;
 }
 
 std::ostream &
 operator<<(std::ostream &os, const Acceptance &a)
 {
-	auto state = a.l.find_first();
 	os << "( ";
-	if (a.l.none()) {
-		os << "none ";
-	} else {
-		while (a.l.npos != state) {
-			os << state << ' ';
-			state = a.l.find_next(state);
-		}
-	}
-	os << ", ";
-	if (a.u.none()) {
-		return os << "none )";
-	}
-	state = a.u.find_first();
-	while (a.u.npos != state) {
-		os << state << ' ';
-		state = a.u.find_next(state);
-	}
-	return os << ')';
+	print_set(os, a.l) << ", ";
+	return print_set(os, a.u) << ')';
 }
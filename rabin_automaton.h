@@ -4,7 +4,12 @@
 #include <list>
 #include <utility>
 
+#include "certificate.h"
+#include "progress.h"
 #include "run.h"
+#include "search_stats.h"
+#include "symmetry.h"
+#include "trace.h"
 
 class Acceptance final
 {
@@ -17,6 +22,13 @@ public:
 };
 std::ostream &operator<<(std::ostream &, const Acceptance &);
 
+// the kinds of acceptance condition of an automaton, whose accepted paths
+// are those that for some Rabin pair (l, u) visit l finitely often and u
+// infinitely often, that for every Streett pair (e, f) visit f infinitely
+// often if they visit e infinitely often, or whose set of states visited
+// infinitely often is one of the Muller sets
+enum Acceptance_kind { ACCEPTANCE_RABIN, ACCEPTANCE_STREETT, ACCEPTANCE_MULLER };
+
 struct Out_transition
 {
 	state_t left;
@@ -36,7 +48,25 @@ private:
 	state_t starting_state;
 	bool has_transitions;
 	std::list<Out_transition> *transitions;
+	Acceptance_kind kind;
 	std::list<Acceptance> conditions;
+	// the Streett pairs (e, f), kept as (l, u), and the Muller sets
+	std::list<Acceptance> streett_pairs;
+	std::list<bitset_t> muller_sets;
+	// bit mask of the Emptiness_check to run before the search
+	unsigned int checks;
+	// the runs found do not depend on the number of threads
+	bool deterministic;
+	// the automorphisms are searched only with at most these states
+	state_t symmetry_bound;
+	// the run found covers every nonempty state, not only the starting one
+	bool all_states;
+	// the file the search saves its state to every checkpoint_heights
+	// heights or checkpoint_seconds seconds, and the one it resumes from
+	const char *checkpoint;
+	unsigned int checkpoint_heights;
+	unsigned int checkpoint_seconds;
+	const char *resume;
 
 public:
 	Rabin_automaton(const state_t);
@@ -49,15 +79,57 @@ public:
 	state_t get_start() const { return starting_state; };
 	void set_start(const state_t q) { starting_state = q; };
 	bool is_valid_state(const state_t q) const { return q < states; };
+	void set_checks(const unsigned int c) { checks = c; };
+	void set_deterministic(const bool d) { deterministic = d; };
+	void set_symmetry_bound(const state_t b) { symmetry_bound = b; };
+	void set_all_states(const bool a) { all_states = a; };
+	void set_checkpoint(const char *const path, const unsigned int heights, const unsigned int seconds)
+	{
+		checkpoint = path;
+		checkpoint_heights = heights;
+		checkpoint_seconds = seconds;
+	};
+	void set_resume(const char *const path) { resume = path; };
+	Acceptance_kind get_acceptance_kind() const { return kind; };
+	void set_acceptance_kind(const Acceptance_kind k) { kind = k; };
 
 	void add_transition(const state_t, const state_t, const state_t);
 	void add_acceptance(const bitset_t &, const bitset_t &);
 	void add_acceptance(bitset_t &&, bitset_t &&);
-	Run *find_run(const int max_threads = 1) const;
+	void add_streett_pair(bitset_t &&, bitset_t &&);
+	void add_muller_set(bitset_t &&);
+	Run *find_run(
+		const int max_threads = 1,
+		Search_stats *const stats = nullptr,
+		Trace *const trace = nullptr,
+		Search_progress *const progress = nullptr) const;
+	bool verify(const Run &) const;
+	// the certificate of an empty language, nullptr if the language is not
+	// empty, and whether a certificate proves it
+	Certificate *find_certificate() const;
+	bool check_certificate(const Certificate &) const;
 
 	std::ostream &print_logic_prog_rep(std::ostream &) const;
+	std::ostream &print_canonical_rep(std::ostream &) const;
 
 private:
+	bool quick_empty(Search_stats *const) const;
+	Run *find_simple_run() const;
+	bool parity_priorities(std::vector<unsigned int> &) const;
+	Run *find_parity_run(const std::vector<unsigned int> &) const;
+	Run *strategy_run(const std::vector<const Out_transition *> &) const;
+	Run *find_record_run() const;
+	Run *search(
+		const int,
+		Search_stats *const,
+		Trace *const,
+		Search_progress *const,
+		const char *const,
+		Run *const) const;
+	Rabin_automaton *quotient(std::vector<state_t> &) const;
+	Run *lift_run(const Run &, const std::vector<state_t> &) const;
+	State_orbits find_orbits() const;
+	bool is_automorphism(const std::vector<state_t> &) const;
 	std::ostream &acceptances_print_logic_prog_rep(std::ostream &) const;
 
 	friend std::ostream &operator<<(std::ostream &, const Rabin_automaton &);
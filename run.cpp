@@ -1,12 +1,19 @@
+#include <list>
+#include <stack>
+#include <string>
+
 #include "run.h"
 
 #define PNODE(h, i) << h << i
 
 Run::Run(const state_t state_num, const state_t start) : states{state_num}, start{start}
 {
-	grafts = new const Run_node *[states]();
-	dependencies = new const Run_node *[states]();
-	roots.reserve(states);
+	grafts = new std::atomic<const Run_node *>[states];
+	dependencies = new std::atomic<const Run_node *>[states];
+	for (state_t q = 0; q < states; q++) {
+		grafts[q].store(nullptr, std::memory_order_relaxed);
+		dependencies[q].store(nullptr, std::memory_order_relaxed);
+	}
 	lock = new std::mutex;
 }
 
@@ -20,47 +27,142 @@ Run::~Run()
 	delete lock;
 }
 
+// a tree claims all its states not yet nonempty at once under the lock, so
+// that two trees saved together never claim part of each other's states and
+// graft onto each other; the trees with no such state are dropped without it
 void
 Run::save_subruns(const Run_node *const n)
 {
-	const std::lock_guard<std::mutex> l(*lock);
-	save_subruns_aux(n, n);
-	if (roots.find(n) == roots.end()) {
+	bool saved = false;
+	if (claimable(n)) {
+		const std::lock_guard<std::mutex> l(*lock);
+		saved = save_subruns_aux(n, n);
+		if (saved) {
+			roots.push_back(n);
+		}
+	}
+	if (!saved) {
 		delete n;
 	}
 }
 
-void
+// whether some internal node of the tree has a state not yet nonempty
+bool
+Run::claimable(const Run_node *const n) const
+{
+	return nullptr != n->left
+		&& (nullptr == grafts[n->state].load(std::memory_order_acquire) || claimable(n->left) || claimable(n->right));
+}
+
+// returns whether some node of the tree of d was claimed, the lock is held
+bool
 Run::save_subruns_aux(const Run_node *const n, const Run_node *const d)
 {
 	if (nullptr == n->left) {
-		return;
+		return false;
+	}
+	bool res = false;
+	if (nullptr == grafts[n->state].load(std::memory_order_relaxed)) {
+		dependencies[n->state].store(d, std::memory_order_release);
+		grafts[n->state].store(n, std::memory_order_release);
+		res = true;
+		if (nullptr != Trace_buffer::local) {
+			Trace_buffer::local->instant("nonempty", n->state);
+		}
+	}
+	res = save_subruns_aux(n->left, d) || res;
+	return save_subruns_aux(n->right, d) || res;
+}
+
+static Run_node *
+image(const Run_node &arg, const std::vector<state_t> &g, Run_node *const p)
+{
+	Run_node *const res = new Run_node(g[arg.state], p);
+	res->graft = arg.graft;
+	if (nullptr != arg.left) {
+		res->left = image(*arg.left, g, res);
+		res->right = image(*arg.right, g, res);
+	}
+	return res;
+}
+
+// saves the image through the automorphism g of the subrun that made q
+// nonempty, unless some graft leaf of the image would refer to a state that
+// is not yet nonempty
+bool
+Run::save_image(const state_t q, const std::vector<state_t> &g)
+{
+	const std::lock_guard<std::mutex> l(*lock);
+	const Run_node *const d = dependencies[q];
+	std::stack<const Run_node *> stack;
+	for (stack.push(d); !stack.empty();) {
+		const Run_node *const n = stack.top();
+		stack.pop();
+		if (nullptr != n->left) {
+			stack.push(n->left);
+			stack.push(n->right);
+		} else if (n->graft && d != dependencies[n->state] && nullptr == grafts[g[n->state]]) {
+			return false;
+		}
+	}
+	Run_node *const n = image(*d, g, nullptr);
+	if (save_subruns_aux(n, n)) {
+		roots.push_back(n);
+	} else {
+		delete n;
 	}
-	if (nullptr == grafts[n->state]) {
-		grafts[n->state] = n;
-		dependencies[n->state] = d;
-		roots.insert(d);
+	return true;
+}
+
+std::size_t
+Run::size() const
+{
+	const std::lock_guard<std::mutex> l(*lock);
+	std::size_t res = 0;
+	std::stack<const Run_node *> stack;
+	for (auto t = roots.cbegin(); t != roots.cend(); t++) {
+		stack.push(*t);
+	}
+	for (; !stack.empty(); res++) {
+		const Run_node *const n = stack.top();
+		stack.pop();
+		if (nullptr != n->left) {
+			stack.push(n->left);
+			stack.push(n->right);
+		}
 	}
-	save_subruns_aux(n->left, d);
-	save_subruns_aux(n->right, d);
+	return res;
 }
 
 std::ostream &
 operator<<(std::ostream &os, const Run &run)
 {
-	const std::lock_guard<std::mutex> l(*run.lock);
-	runid_t free_id = 1;
-	const Run_node *root = run.grafts[run.start];
-	if (root != run.dependencies[run.start]) {
-		Run_node r(run.start);
-		r.graft = true;
-		root = &r;
-	}
+	return run.print_roots(os, std::vector<state_t>(1, run.start));
+}
+
+// the runs of the states of starts, each with a root of its own, which is a
+// graft leaf unless the node of its state is the root of a tree not yet
+// printed
+std::ostream &
+Run::print_roots(std::ostream &os, const std::vector<state_t> &starts) const
+{
+	const std::lock_guard<std::mutex> l(*lock);
+	runid_t free_id = starts.size();
+	std::list<Run_node> leaves;
 	std::unordered_map<const Run_node *, runid_t> id_map;
 	os << "digraph {" << std::endl;
 	os << "    node [shape = circle]" << std::endl;
-	run.out_aux(os, root, 0, free_id, id_map);
-	return os << std::endl << '}';
+	for (runid_t i = 0; i < starts.size(); i++) {
+		const state_t q = starts[i];
+		const Run_node *root = grafts[q];
+		if (root != dependencies[q] || id_map.end() != id_map.find(root)) {
+			leaves.emplace_back(q);
+			leaves.back().graft = true;
+			root = &leaves.back();
+		}
+		out_aux(os, root, i, starts.size(), free_id, id_map) << std::endl;
+	}
+	return os << '}';
 }
 
 std::ostream &
@@ -68,11 +170,12 @@ Run::out_aux(
 	std::ostream &os,
 	const Run_node *node,
 	const runid_t id,
+	const runid_t roots,
 	runid_t &free_id,
 	std::unordered_map<const Run_node *, runid_t> &id_map) const
 {
 	id_map[node] = id;
-	if (0 == id) {
+	if (id < roots) {
 		os << "    r" << id << " [label = \"" << node->state << "\", shape = Mcircle]";
 	} else {
 		os << "    r" << id << " [label = \"" << node->state << "\"]";
@@ -88,15 +191,15 @@ Run::out_aux(
 		os PNODE("                        r", id) PNODE(" -> i", id) << " [style=invis]" << std::endl;
 
 		os PNODE("    r", id) PNODE(" -> { r", left_id) PNODE(" r", right_id) << " }" << std::endl;
-		out_aux(os, node->left, left_id, free_id, id_map) << std::endl;
-		out_aux(os, node->right, right_id, free_id, id_map);
+		out_aux(os, node->left, left_id, roots, free_id, id_map) << std::endl;
+		out_aux(os, node->right, right_id, roots, free_id, id_map);
 		return os;
 	}
 	if (node->graft) {
 		os << std::endl;
 		auto t = id_map.find(grafts[node->state]);
 		if (id_map.end() == t) { // graft not yet printed
-			out_aux(os, dependencies[node->state], free_id++, free_id, id_map);
+			out_aux(os, dependencies[node->state], free_id++, roots, free_id, id_map);
 			os << std::endl;
 			t = id_map.find(grafts[node->state]);
 		}
@@ -150,3 +253,117 @@ Run::print_logic_prog_rep_aux(
 	}
 	return os;
 }
+
+// the trees of the run in preorder, a token per node (i internal, l leaf, g
+// graft leaf, followed by the state), and then the node of each graft as its
+// tree and its preorder index in that tree
+std::ostream &
+Run::serialize(std::ostream &os) const
+{
+	const std::lock_guard<std::mutex> l(*lock);
+	std::unordered_map<const Run_node *, std::pair<std::size_t, std::size_t>> index;
+	os << "trees " << roots.size() << std::endl;
+	std::size_t tree = 0;
+	for (auto t = roots.cbegin(); t != roots.cend(); t++, tree++) {
+		std::size_t i = 0;
+		std::stack<const Run_node *> stack;
+		for (stack.push(*t); !stack.empty(); i++) {
+			const Run_node *const n = stack.top();
+			stack.pop();
+			index.emplace(n, std::make_pair(tree, i));
+			os << ((0 < i) ? " " : "") << ((nullptr != n->left) ? 'i' : (n->graft ? 'g' : 'l')) << n->state;
+			if (nullptr != n->left) {
+				stack.push(n->right);
+				stack.push(n->left);
+			}
+		}
+		os << std::endl;
+	}
+	std::size_t nonempty = 0;
+	for (state_t q = 0; q < states; q++) {
+		nonempty += (nullptr != grafts[q]) ? 1 : 0;
+	}
+	os << "grafts " << nonempty << std::endl;
+	for (state_t q = 0; q < states; q++) {
+		if (nullptr != grafts[q]) {
+			const auto &i = index.at(grafts[q]);
+			os << q << ' ' << i.first << ' ' << i.second << std::endl;
+		}
+	}
+	return os;
+}
+
+// reads back the output of serialize, returns nullptr if it is malformed or
+// it is not a run of start with states states, unless partial is set and only
+// start is still empty; every tree and graft claims a state of its own, so
+// their counts are at most states before anything is allocated for them
+Run *
+Run::deserialize(std::istream &is, const state_t states, const state_t start, const bool partial)
+{
+	std::string word;
+	std::size_t trees = 0;
+	if (!(is >> word >> trees) || "trees" != word || states < trees) {
+		return nullptr;
+	}
+	Run *const res = new Run(states, start);
+	std::vector<std::vector<Run_node *>> nodes(trees);
+	bool ok = true;
+	for (std::size_t t = 0; t < trees && ok; t++) {
+		// the nodes still missing their right child
+		std::stack<Run_node *> open;
+		do {
+			char kind = '\0';
+			state_t q = 0;
+			if (!(is >> kind >> q) || states <= q || ('i' != kind && 'l' != kind && 'g' != kind)) {
+				ok = false;
+				break;
+			}
+			Run_node *p = nullptr;
+			if (!open.empty()) {
+				p = open.top();
+				if (nullptr != p->left) {
+					open.pop();
+				}
+			}
+			Run_node *const n = new Run_node(q, p);
+			n->graft = 'g' == kind;
+			if (nullptr == p) {
+				res->roots.push_back(n);
+			} else if (nullptr == p->left) {
+				p->left = n;
+			} else {
+				p->right = n;
+			}
+			if ('i' == kind) {
+				open.push(n);
+			}
+			nodes[t].push_back(n);
+		} while (!open.empty());
+	}
+	std::size_t nonempty = 0;
+	if (!ok || !(is >> word >> nonempty) || "grafts" != word || states < nonempty) {
+		ok = false;
+		nonempty = 0;
+	}
+	for (std::size_t k = 0; k < nonempty && ok; k++) {
+		state_t q = 0;
+		std::size_t t = 0;
+		std::size_t i = 0;
+		ok = (is >> q >> t >> i) && q < states && t < trees && i < nodes[t].size() && nodes[t][i]->state == q
+			&& nullptr != nodes[t][i]->left && nullptr == res->grafts[q];
+		if (ok) {
+			res->grafts[q] = nodes[t][i];
+			res->dependencies[q] = nodes[t][0];
+		}
+	}
+	for (std::size_t t = 0; t < trees && ok; t++) {
+		for (auto n = nodes[t].cbegin(); n != nodes[t].cend() && ok; n++) {
+			ok = !(*n)->graft || nullptr != res->grafts[(*n)->state];
+		}
+	}
+	if (!ok || (!partial && nullptr == res->grafts[start])) {
+		delete res;
+		return nullptr;
+	}
+	return res;
+}
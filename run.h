@@ -1,12 +1,15 @@
 #ifndef RUN_H
 #define RUN_H
 
+#include <atomic>
+#include <istream>
 #include <mutex>
 #include <ostream>
 #include <unordered_map>
-#include <unordered_set>
+#include <vector>
 
 #include "run_node.h"
+#include "trace.h"
 
 class Run final
 {
@@ -15,9 +18,12 @@ public:
 	const state_t start;
 
 private:
-	const Run_node **grafts;
-	const Run_node **dependencies;
-	std::unordered_set<const Run_node *> roots;
+	// the first tree saving an internal node of a state claims it under the
+	// lock, so that the nonempty states are read without locking while the
+	// search saves other trees
+	std::atomic<const Run_node *> *grafts;
+	std::atomic<const Run_node *> *dependencies;
+	std::vector<const Run_node *> roots;
 	std::mutex *lock;
 
 public:
@@ -28,19 +34,28 @@ public:
 	Run &operator=(const Run &) = delete;
 	Run &operator=(Run &&) = delete;
 
-	bool nonempty(const state_t q) const { return nullptr != grafts[q]; };
+	bool nonempty(const state_t q) const { return nullptr != grafts[q].load(std::memory_order_acquire); };
+	const Run_node *graft(const state_t q) const { return grafts[q].load(std::memory_order_acquire); };
+	const Run_node *dependency(const state_t q) const { return dependencies[q].load(std::memory_order_acquire); };
 	void save_subruns(const Run_node *const);
+	bool save_image(const state_t, const std::vector<state_t> &);
+	std::size_t size() const;
 
+	std::ostream &print_roots(std::ostream &, const std::vector<state_t> &) const;
 	std::ostream &print_logic_prog_rep(std::ostream &) const;
+	std::ostream &serialize(std::ostream &) const;
+	static Run *deserialize(std::istream &, const state_t, const state_t, const bool = false);
 
 private:
-	void save_subruns_aux(const Run_node *const, const Run_node *const);
+	bool claimable(const Run_node *const) const;
+	bool save_subruns_aux(const Run_node *const, const Run_node *const);
 	std::ostream &print_logic_prog_rep_aux(
 		std::ostream &, const Run_node *const, runid_t &, std::unordered_map<const Run_node *, runid_t> &) const;
 	std::ostream &out_aux(
 		std::ostream &,
 		const Run_node *const,
 		const runid_t,
+		const runid_t,
 		runid_t &,
 		std::unordered_map<const Run_node *, runid_t> &) const;
 
@@ -0,0 +1,82 @@
+#include <iomanip>
+
+#include "search_stats.h"
+
+static double
+milliseconds(const search_clock::duration d)
+{
+	return std::chrono::duration_cast<std::chrono::duration<double, std::milli>>(d).count();
+}
+
+void
+Height_stats::merge(const Height_stats &arg)
+{
+	pieces += arg.pieces;
+	generated += arg.generated;
+	scanned += arg.scanned;
+	accepted += arg.accepted;
+	deduplicated += arg.deduplicated;
+	invalidated += arg.invalidated;
+	if (max_state_pieces < arg.max_state_pieces) {
+		max_state_pieces = arg.max_state_pieces;
+		max_state = arg.max_state;
+	}
+	nonempty += arg.nonempty;
+	time += arg.time;
+}
+
+void
+Search_stats::merge(const Search_stats &arg)
+{
+	for (int c = 0; c < CHECKS; c++) {
+		checks_fired[c] += arg.checks_fired[c];
+	}
+	for (int p = 0; p < PHASES; p++) {
+		phase_time[p] += arg.phase_time[p];
+	}
+	for (state_t h = 0; h < arg.per_height.size(); h++) {
+		height(h).merge(arg.per_height[h]);
+	}
+	if (peak_piece_bytes < arg.peak_piece_bytes) {
+		peak_piece_bytes = arg.peak_piece_bytes;
+	}
+	run_node_bytes += arg.run_node_bytes;
+	spilled_bytes += arg.spilled_bytes;
+}
+
+std::ostream &
+operator<<(std::ostream &os, const Search_stats &stats)
+{
+	const std::ios::fmtflags flags = os.flags();
+	os << "height      pieces   generated     scanned    accepted  duplicate   invalid  max/state  nonempty   time(ms)"
+	   << std::endl;
+	for (state_t h = 0; h < stats.per_height.size() && h < stats.heights; h++) {
+		const Height_stats &s = stats.per_height[h];
+		os << std::setw(6) << h << std::setw(12) << s.pieces << std::setw(12) << s.generated << std::setw(12)
+		   << s.scanned << std::setw(12) << s.accepted << std::setw(11) << s.deduplicated << std::setw(10)
+		   << s.invalidated << std::setw(7) << s.max_state_pieces << '@' << std::setw(3) << std::left << s.max_state
+		   << std::right << std::setw(10) << s.nonempty << std::setw(11) << std::fixed << std::setprecision(3)
+		   << milliseconds(s.time) << std::endl;
+		os.flags(flags);
+	}
+	os << "found in the cache: " << (stats.cached ? "yes" : "no") << std::endl;
+	os << "emptiness checks fired:";
+	for (int c = 0; c < CHECKS; c++) {
+		os << ((0 < c) ? ", " : " ") << check_name[c] << ' ' << stats.checks_fired[c];
+	}
+	os << std::endl;
+	os << "solved as a parity game: " << (stats.parity ? "yes" : "no") << std::endl;
+	os << "found by the single condition pre-pass: " << (stats.simple_run ? "yes" : "no") << std::endl;
+	os << "heights: " << stats.heights << std::endl;
+	os << "stopped at a fixpoint: " << (stats.fixpoint ? "yes" : "no") << std::endl;
+	os << "states after bisimulation: " << stats.quotient_states << std::endl;
+	os << "state orbits: " << stats.orbits << std::endl;
+	for (int p = 0; p < PHASES; p++) {
+		os << phase_name[p] << " time: " << std::fixed << std::setprecision(3) << milliseconds(stats.phase_time[p])
+		   << " ms" << std::endl;
+	}
+	os.flags(flags);
+	os << "peak bytes in piece tables: " << stats.peak_piece_bytes << std::endl;
+	os << "bytes in run nodes: " << stats.run_node_bytes << std::endl;
+	return os << "bytes spilled to disk: " << stats.spilled_bytes << std::endl;
+}
@@ -0,0 +1,114 @@
+#ifndef SEARCH_STATS_H
+#define SEARCH_STATS_H
+
+#include <chrono>
+#include <ostream>
+#include <vector>
+
+#include "typedefs.h"
+
+typedef std::chrono::steady_clock search_clock;
+typedef uint_least64_t counter_t;
+
+// the counters of the search can be compiled out with -DNO_SEARCH_STATS,
+// leaving only the (per height) phase times
+#ifdef NO_SEARCH_STATS
+#define STATS_ADD(s, field, n) static_cast<void>(s)
+#else
+#define STATS_ADD(s, field, n) \
+	do { \
+		if (nullptr != (s)) { \
+			(s)->field += (n); \
+		} \
+	} while (0)
+#endif
+
+enum Search_phase { PHASE_GENERATION, PHASE_SORT, PHASE_MERGE, PHASE_INVALIDATION, PHASE_REMOVAL, PHASES };
+
+// PHASE_SORT is the sum of the time spent sorting by every worker, it is
+// already contained in the wall time of PHASE_GENERATION
+constexpr const char *phase_name[PHASES] = {"generation", "sort", "merge", "invalidation", "removal"};
+
+// the over-approximating checks able to prove emptiness before the search
+enum Emptiness_check { CHECK_PRODUCTIVE, CHECK_CYCLES, CHECK_PRUNING, CHECKS };
+
+constexpr const char *check_name[CHECKS] = {"productive", "cycles", "pruning"};
+
+// the bit of the checks enabling the shortcuts taken for Rabin pairs before
+// the search: the parity game, the runs in a single acceptance condition and
+// the quotient by bisimulation
+constexpr unsigned int CHECK_SHORTCUTS = 1 << CHECKS;
+constexpr unsigned int ALL_CHECKS = (CHECK_SHORTCUTS << 1) - 1;
+
+class Height_stats final
+{
+public:
+	counter_t pieces;
+	counter_t generated;
+	counter_t scanned;
+	counter_t accepted;
+	counter_t deduplicated;
+	counter_t invalidated;
+	counter_t max_state_pieces;
+	state_t max_state;
+	counter_t nonempty;
+	search_clock::duration time;
+
+	Height_stats()
+		: pieces{0}
+		, generated{0}
+		, scanned{0}
+		, accepted{0}
+		, deduplicated{0}
+		, invalidated{0}
+		, max_state_pieces{0}
+		, max_state{0}
+		, nonempty{0}
+		, time{} {};
+
+	void merge(const Height_stats &);
+};
+
+class Search_stats final
+{
+public:
+	bool cached;
+	counter_t checks_fired[CHECKS];
+	bool simple_run;
+	bool parity;
+	state_t heights;
+	bool fixpoint;
+	state_t quotient_states;
+	state_t orbits;
+	search_clock::duration phase_time[PHASES];
+	std::vector<Height_stats> per_height;
+	counter_t peak_piece_bytes;
+	counter_t run_node_bytes;
+	counter_t spilled_bytes;
+
+	Search_stats()
+		: cached{false}
+		, checks_fired{}
+		, simple_run{false}
+		, parity{false}
+		, heights{0}
+		, fixpoint{false}
+		, quotient_states{0}
+		, orbits{0}
+		, phase_time{}
+		, peak_piece_bytes{0}
+		, run_node_bytes{0}
+		, spilled_bytes{0} {};
+
+	Height_stats &height(const state_t h)
+	{
+		if (per_height.size() <= h) {
+			per_height.resize(h + 1);
+		}
+		return per_height[h];
+	};
+	void merge(const Search_stats &);
+};
+std::ostream &operator<<(std::ostream &, const Search_stats &);
+
+#endif
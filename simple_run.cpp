@@ -0,0 +1,132 @@
+#include <algorithm>
+#include <vector>
+
+#include "rabin_automaton.h"
+
+namespace
+{
+// the tree of the positional strategy move from q, every state is an internal
+// node once and its other occurrences are graft leaves
+Run_node *
+strategy_tree(
+	const state_t q, Run_node *const p, const std::vector<const Out_transition *> &move, std::vector<bool> &visited)
+{
+	Run_node *const n = new Run_node(q, p);
+	visited[q] = true;
+	const state_t children[2] = {move[q]->left, move[q]->right};
+	Run_node **const slots[2] = {&n->left, &n->right};
+	for (int i = 0; i < 2; i++) {
+		if (visited[children[i]]) {
+			*slots[i] = new Run_node(children[i], n);
+			(*slots[i])->graft = true;
+		} else {
+			*slots[i] = strategy_tree(children[i], n, move, visited);
+		}
+	}
+	return n;
+}
+} // namespace
+
+// looks for a run that every path leaves after a finite prefix, to stay in
+// the states of one acceptance condition that avoid l and visit u infinitely
+// often (Büchi games on the states not in l, one condition at a time), the
+// states won for a condition are winning targets for the next ones; with
+// all_states it goes on past the starting state and returns the run of all
+// the states won, if any
+Run *
+Rabin_automaton::find_simple_run() const
+{
+	if (!has_transitions || conditions.empty()) {
+		return nullptr;
+	}
+	std::vector<const Out_transition *> move(states, nullptr);
+	std::vector<bool> won(states, false);
+	const auto into = [&won](const Out_transition &t, const bitset_t &x) -> bool {
+		return (won[t.left] || x.test(t.left)) && (won[t.right] || x.test(t.right));
+	};
+	for (bool changed = true; changed && (all_states || !won[starting_state]);) {
+		changed = false;
+		for (auto a = conditions.cbegin(); a != conditions.cend(); a++) {
+			bitset_t x(states);
+			for (state_t q = 0; q < states; q++) {
+				if (!won[q] && !a->l.test(q)) {
+					x.set(q);
+				}
+			}
+			std::vector<const Out_transition *> m(states, nullptr);
+			for (;;) {
+				// the states of x that reach, through x, the states of u
+				// having a transition into x
+				bitset_t y(states);
+				for (auto q = x.find_first(); x.npos != q; q = x.find_next(q)) {
+					for (auto t = transitions[q].cbegin(); a->u.test(q) && t != transitions[q].cend(); t++) {
+						if (into(*t, x)) {
+							y.set(q);
+							m[q] = &*t;
+							break;
+						}
+					}
+				}
+				for (bool added = true; added;) {
+					added = false;
+					for (auto q = x.find_first(); x.npos != q; q = x.find_next(q)) {
+						for (auto t = transitions[q].cbegin(); !y.test(q) && t != transitions[q].cend(); t++) {
+							if (into(*t, y)) {
+								y.set(q);
+								m[q] = &*t;
+								added = true;
+							}
+						}
+					}
+				}
+				if (y == x) {
+					break;
+				}
+				x = std::move(y);
+			}
+			for (auto q = x.find_first(); x.npos != q; q = x.find_next(q)) {
+				won[q] = true;
+				move[q] = m[q];
+				changed = true;
+			}
+		}
+		// the states attracted to the won ones
+		for (bool added = true; added;) {
+			added = false;
+			for (state_t q = 0; q < states; q++) {
+				for (auto t = transitions[q].cbegin(); !won[q] && t != transitions[q].cend(); t++) {
+					if (won[t->left] && won[t->right]) {
+						won[q] = true;
+						move[q] = &*t;
+						added = true;
+						changed = true;
+					}
+				}
+			}
+		}
+	}
+	if (!won[starting_state] && (!all_states || std::find(won.cbegin(), won.cend(), true) == won.cend())) {
+		return nullptr;
+	}
+	return strategy_run(move);
+}
+
+// the run of the positional strategy move, defined on the states reached from
+// the starting state, with a node for each of these states; with all_states
+// it is defined on the states reached from any state where it is defined,
+// and the run also has a tree for each of them not yet reached
+Run *
+Rabin_automaton::strategy_run(const std::vector<const Out_transition *> &move) const
+{
+	std::vector<bool> visited(states, false);
+	Run *const res = new Run(states, starting_state);
+	if (nullptr != move[starting_state]) {
+		res->save_subruns(strategy_tree(starting_state, nullptr, move, visited));
+	}
+	for (state_t q = 0; all_states && q < states; q++) {
+		if (nullptr != move[q] && !visited[q]) {
+			res->save_subruns(strategy_tree(q, nullptr, move, visited));
+		}
+	}
+	return res;
+}
@@ -0,0 +1,234 @@
+#include <atomic>
+#include <cerrno>
+#include <deque>
+#include <fcntl.h>
+#include <mutex>
+#include <string>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <unordered_map>
+#include <vector>
+
+#include "spill.h"
+
+namespace
+{
+// a mapped file, whose used bytes are those carved from first on
+struct Chunk
+{
+	char *base;
+	std::size_t size;
+	std::size_t used;
+	std::size_t first;
+};
+
+// freed blocks by size, the search allocates few distinct sizes
+typedef std::unordered_map<std::size_t, std::vector<char *>> Free_blocks;
+
+// the rest of the slab of a thread, as long as its layer is the current one,
+// and the blocks the thread freed
+struct Arena
+{
+	char *next;
+	char *end;
+	unsigned int layer;
+	Free_blocks free_blocks;
+
+	Arena() : next{nullptr}, end{nullptr}, layer{0} {};
+	~Arena();
+};
+} // namespace
+
+constexpr std::size_t chunk_size = 64 << 20;
+constexpr std::size_t slab_size = 64 << 10;
+constexpr std::size_t alignment = alignof(std::max_align_t);
+
+bool Spill_store::active = false;
+
+static std::mutex lock;
+static std::size_t resident_target = 0;
+static std::string directory;
+static std::vector<Chunk> chunks;
+// the bytes carved so far, where each layer still in memory starts, the last
+// one being the layer of the current height, and the bytes written back
+static std::size_t carved = 0;
+static std::deque<std::size_t> layers;
+static std::size_t spilled = 0;
+static std::atomic<unsigned int> current_layer{0};
+// the blocks freed by the threads that exited, adopted by the next thread
+// taking a slab
+static Free_blocks orphan_blocks;
+static thread_local Arena arena;
+
+Arena::~Arena()
+{
+	if (free_blocks.empty()) {
+		return;
+	}
+	const std::lock_guard<std::mutex> l(lock);
+	try {
+		for (auto f = free_blocks.begin(); f != free_blocks.end(); f++) {
+			std::vector<char *> &o = orphan_blocks[f->first];
+			o.insert(o.end(), f->second.cbegin(), f->second.cend());
+		}
+	} catch (const std::bad_alloc &e) {
+		// the blocks are leaked until the end of the process
+	}
+}
+
+// on failure returns false with errno set
+static bool
+new_chunk(const std::size_t min_size)
+{
+	const std::size_t size = (chunk_size < min_size) ? min_size : chunk_size;
+	std::string path = directory + "/bracket-spill-XXXXXX";
+	const int fd = mkstemp(&path[0]);
+	if (-1 == fd) {
+		return false;
+	}
+	unlink(path.c_str());
+	const int err = posix_fallocate(fd, 0, static_cast<off_t>(size));
+	if (0 != err) {
+		close(fd);
+		errno = err;
+		return false;
+	}
+	void *const base = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+	if (MAP_FAILED == base) {
+		return false;
+	}
+	chunks.push_back({static_cast<char *>(base), size, 0, carved});
+	return true;
+}
+
+// with the lock held, returns nullptr on failure
+static char *
+carve(const std::size_t n)
+{
+	if (chunks.back().size - chunks.back().used < n && !new_chunk(n)) {
+		return nullptr;
+	}
+	Chunk &c = chunks.back();
+	char *const res = c.base + c.used;
+	c.used += n;
+	carved += n;
+	return res;
+}
+
+// writes back and drops from memory the bytes carved from from to to, the
+// pages they share with the next layer are only read back from the files
+static void
+spill(const std::size_t from, const std::size_t to)
+{
+	const std::size_t page = sysconf(_SC_PAGESIZE);
+	for (auto c = chunks.cbegin(); c != chunks.cend(); c++) {
+		const std::size_t b = (from < c->first) ? c->first : from;
+		const std::size_t e = (c->first + c->used < to) ? c->first + c->used : to;
+		if (e <= b) {
+			continue;
+		}
+		char *const p = c->base + (b - c->first) / page * page;
+		const std::size_t len = c->base + (e - c->first) - p;
+		msync(p, len, MS_ASYNC);
+#ifdef MADV_PAGEOUT
+		if (0 == madvise(p, len, MADV_PAGEOUT)) {
+			continue;
+		}
+#endif
+		madvise(p, len, MADV_DONTNEED);
+	}
+}
+
+bool
+Spill_store::configure(const std::size_t target, const char *dir)
+{
+	const std::lock_guard<std::mutex> l(lock);
+	resident_target = target;
+	directory = dir;
+	if (chunks.empty() && !new_chunk(0)) {
+		return false;
+	}
+	layers.assign(1, carved);
+	active = true;
+	return true;
+}
+
+void *
+Spill_store::allocate(const std::size_t bytes)
+{
+	const std::size_t n = (0 == bytes) ? alignment : (bytes + alignment - 1) / alignment * alignment;
+	auto f = arena.free_blocks.find(n);
+	if (arena.free_blocks.end() != f && !f->second.empty()) {
+		char *const res = f->second.back();
+		f->second.pop_back();
+		return res;
+	}
+	if (arena.layer == current_layer.load(std::memory_order_relaxed)
+		&& n <= static_cast<std::size_t>(arena.end - arena.next)) {
+		char *const res = arena.next;
+		arena.next += n;
+		return res;
+	}
+	const std::lock_guard<std::mutex> l(lock);
+	if (!orphan_blocks.empty()) {
+		for (auto o = orphan_blocks.begin(); o != orphan_blocks.end(); o++) {
+			std::vector<char *> &v = arena.free_blocks[o->first];
+			v.insert(v.end(), o->second.cbegin(), o->second.cend());
+		}
+		orphan_blocks.clear();
+		f = arena.free_blocks.find(n);
+		if (arena.free_blocks.end() != f && !f->second.empty()) {
+			char *const res = f->second.back();
+			f->second.pop_back();
+			return res;
+		}
+	}
+	// the blocks larger than a slab are carved on their own
+	char *const res = carve((slab_size < n) ? n : slab_size);
+	if (nullptr == res) {
+		throw std::bad_alloc();
+	}
+	if (n <= slab_size) {
+		arena.next = res + n;
+		arena.end = res + slab_size;
+		arena.layer = current_layer.load(std::memory_order_relaxed);
+	}
+	return res;
+}
+
+void
+Spill_store::deallocate(void *const p, const std::size_t bytes) noexcept
+{
+	const std::size_t n = (0 == bytes) ? alignment : (bytes + alignment - 1) / alignment * alignment;
+	try {
+		arena.free_blocks[n].push_back(static_cast<char *>(p));
+	} catch (const std::bad_alloc &e) {
+		// the block is leaked until the end of the process
+	}
+}
+
+// the rest of the slabs of the closed layer is left unused, so that each
+// layer is a range of the carved bytes
+void
+Spill_store::end_layer()
+{
+	if (!active) {
+		return;
+	}
+	const std::lock_guard<std::mutex> l(lock);
+	current_layer.fetch_add(1, std::memory_order_relaxed);
+	layers.push_back(carved);
+	while (1 < layers.size() && resident_target < carved - layers.front()) {
+		spill(layers[0], layers[1]);
+		spilled += layers[1] - layers[0];
+		layers.pop_front();
+	}
+}
+
+std::size_t
+Spill_store::spilled_bytes()
+{
+	const std::lock_guard<std::mutex> l(lock);
+	return spilled;
+}
@@ -0,0 +1,72 @@
+#ifndef SPILL_H
+#define SPILL_H
+
+#include <cstddef>
+#include <new>
+
+// process wide store of the memory of the search: until it is configured,
+// before anything is allocated through it, it is a plain wrapper of operator
+// new, afterwards every thread carves its blocks without locking from a slab
+// of its own of unlinked files mapped in memory, and the layers of blocks of
+// the heights already finished are written back and dropped from memory,
+// oldest first, while the layers still in memory exceed the resident target,
+// so that the kernel can reclaim their pages instead of running out of memory
+class Spill_store final
+{
+	static bool active;
+
+public:
+	Spill_store() = delete;
+
+	// target is in bytes, on failure returns false with errno set
+	static bool configure(const std::size_t target, const char *dir);
+	static bool is_active() { return active; };
+	static void *allocate(const std::size_t);
+	static void deallocate(void *const, const std::size_t) noexcept;
+	// closes the layer of the current height, called between heights
+	static void end_layer();
+	static std::size_t spilled_bytes();
+};
+
+template <class T>
+class Spill_allocator
+{
+public:
+	typedef T value_type;
+
+	Spill_allocator() noexcept {};
+	template <class U>
+	Spill_allocator(const Spill_allocator<U> &) noexcept {}
+
+	T *allocate(const std::size_t n)
+	{
+		if (!Spill_store::is_active()) {
+			return static_cast<T *>(::operator new(n * sizeof(T)));
+		}
+		return static_cast<T *>(Spill_store::allocate(n * sizeof(T)));
+	};
+	void deallocate(T *const p, const std::size_t n) noexcept
+	{
+		if (!Spill_store::is_active()) {
+			::operator delete(p);
+		} else {
+			Spill_store::deallocate(p, n * sizeof(T));
+		}
+	};
+};
+
+template <class T, class U>
+bool
+operator==(const Spill_allocator<T> &, const Spill_allocator<U> &)
+{
+	return true;
+}
+
+template <class T, class U>
+bool
+operator!=(const Spill_allocator<T> &, const Spill_allocator<U> &)
+{
+	return false;
+}
+
+#endif
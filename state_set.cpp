@@ -0,0 +1,196 @@
+#include <iterator>
+
+#include "boost/iterator/function_output_iterator.hpp"
+#include "state_set.h"
+
+void
+State_set::to_dense()
+{
+	std::vector<block_t, Spill_allocator<block_t>> v(blocks());
+	for (auto w = words.cbegin(); w != words.cend(); w++) {
+		v[*w / bitset_t::bits_per_block] |= block_t{1} << (*w % bitset_t::bits_per_block);
+	}
+	words.swap(v);
+}
+
+void
+State_set::to_sparse()
+{
+	std::vector<block_t, Spill_allocator<block_t>> v;
+	v.reserve(count);
+	for (std::size_t i = 0; i < words.size(); i++) {
+		for (block_t b = words[i]; 0 != b; b &= b - 1) {
+			v.push_back(i * bitset_t::bits_per_block + __builtin_ctzl(b));
+		}
+	}
+	words.swap(v);
+}
+
+state_t
+State_set::before(const state_t q) const
+{
+	if (!dense()) {
+		const auto w = std::lower_bound(words.cbegin(), words.cend(), block_t{q});
+		return (words.cbegin() != w) ? *std::prev(w) + 1 : 0;
+	}
+	if (0 == q) {
+		return 0;
+	}
+	std::size_t i = (q - 1) / bitset_t::bits_per_block;
+	block_t b = words[i] & (~block_t{0} >> (bitset_t::bits_per_block - 1 - (q - 1) % bitset_t::bits_per_block));
+	for (;;) {
+		if (0 != b) {
+			return (i + 1) * bitset_t::bits_per_block - __builtin_clzl(b);
+		}
+		if (0 == i) {
+			return 0;
+		}
+		b = words[--i];
+	}
+}
+
+void
+State_set::insert(const state_t q)
+{
+	const auto w = std::lower_bound(words.begin(), words.end(), block_t{q});
+	if (words.end() != w && block_t{q} == *w) {
+		return;
+	}
+	if (count < sparse_max()) {
+		words.insert(w, q);
+	} else {
+		to_dense();
+		words[q / bitset_t::bits_per_block] |= block_t{1} << (q % bitset_t::bits_per_block);
+	}
+	count++;
+}
+
+void
+State_set::reset(const state_t q)
+{
+	if (!dense()) {
+		const auto w = std::lower_bound(words.begin(), words.end(), block_t{q});
+		if (words.end() != w && block_t{q} == *w) {
+			words.erase(w);
+			count--;
+		}
+		return;
+	}
+	const block_t bit = block_t{1} << (q % bitset_t::bits_per_block);
+	if (0 != (words[q / bitset_t::bits_per_block] & bit)) {
+		words[q / bitset_t::bits_per_block] &= ~bit;
+		count--;
+		if (!dense()) {
+			to_sparse();
+		}
+	}
+}
+
+void
+State_set::assign_image(const State_set &s, const std::vector<state_t> &g)
+{
+	std::vector<block_t, Spill_allocator<block_t>> v;
+	states = s.states;
+	count = s.count;
+	if (dense()) {
+		v.resize(blocks());
+		s.for_each([&v, &g](const state_t q) {
+			v[g[q] / bitset_t::bits_per_block] |= block_t{1} << (g[q] % bitset_t::bits_per_block);
+		});
+	} else {
+		v.reserve(count);
+		s.for_each([&v, &g](const state_t q) { v.push_back(g[q]); });
+		std::sort(v.begin(), v.end());
+	}
+	words.swap(v);
+}
+
+bool
+State_set::intersects(const bitset_t &b) const
+{
+	if (!dense()) {
+		for (auto w = words.cbegin(); w != words.cend(); w++) {
+			if (b.test(*w)) {
+				return true;
+			}
+		}
+		return false;
+	}
+	// the blocks of b are read in place, in order, and-ed with the words
+	bool res = false;
+	std::size_t i = 0;
+	boost::to_block_range(b, boost::make_function_output_iterator([this, &res, &i](const block_t x) {
+		res = res || (i < words.size() && 0 != (words[i] & x));
+		i++;
+	}));
+	return res;
+}
+
+void
+State_set::unite(const State_set &rhs)
+{
+	// the union has at least as many elements as each of them, so it is
+	// dense if either is
+	if (dense() || rhs.dense()) {
+		if (!dense()) {
+			std::vector<block_t, Spill_allocator<block_t>> v(rhs.words);
+			for (auto w = words.cbegin(); w != words.cend(); w++) {
+				v[*w / bitset_t::bits_per_block] |= block_t{1} << (*w % bitset_t::bits_per_block);
+			}
+			words.swap(v);
+		} else {
+			for (auto w = rhs.words.cbegin(); w != rhs.words.cend(); w++) {
+				words[*w / bitset_t::bits_per_block] |= block_t{1} << (*w % bitset_t::bits_per_block);
+			}
+		}
+		count = 0;
+		for (auto w = words.cbegin(); w != words.cend(); w++) {
+			count += __builtin_popcountl(*w);
+		}
+		return;
+	}
+	// the union is counted first to allocate it at once
+	state_t n = 0;
+	for (auto x = words.cbegin(), y = rhs.words.cbegin(); words.cend() != x || rhs.words.cend() != y; n++) {
+		if (rhs.words.cend() == y || (words.cend() != x && *x < *y)) {
+			x++;
+		} else if (words.cend() == x || *y < *x) {
+			y++;
+		} else {
+			x++;
+			y++;
+		}
+	}
+	if (n == count) {
+		return;
+	}
+	if (sparse_max() < n) {
+		to_dense();
+		for (auto w = rhs.words.cbegin(); w != rhs.words.cend(); w++) {
+			words[*w / bitset_t::bits_per_block] |= block_t{1} << (*w % bitset_t::bits_per_block);
+		}
+	} else {
+		std::vector<block_t, Spill_allocator<block_t>> v;
+		v.reserve(n);
+		std::set_union(words.cbegin(), words.cend(), rhs.words.cbegin(), rhs.words.cend(), std::back_inserter(v));
+		words.swap(v);
+	}
+	count = n;
+}
+
+bool
+State_set::less(const State_set &lhs, const State_set &rhs)
+{
+	if (!lhs.dense() && !rhs.dense()) {
+		return std::lexicographical_compare(
+			lhs.words.crbegin(), lhs.words.crend(), rhs.words.crbegin(), rhs.words.crend());
+	}
+	// the greatest element in only one of them decides
+	state_t x = lhs.before(lhs.states);
+	state_t y = rhs.before(rhs.states);
+	while (x == y && 0 != x) {
+		x = lhs.before(x - 1);
+		y = rhs.before(y - 1);
+	}
+	return x < y;
+}
@@ -0,0 +1,127 @@
+#ifndef STATE_SET_H
+#define STATE_SET_H
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+#include "typedefs.h"
+
+// set of states of an automaton kept as the increasing array of its elements
+// while they take no more words than a bitset of all the states, and as that
+// bitset beyond, so that the small sets of large automata take memory and time
+// in proportion to their elements; the representation only depends on the
+// number of elements, so equal sets have equal words
+class State_set final
+{
+public:
+	typedef bitset_t::block_type block_t;
+
+private:
+	// the elements or the blocks of the bitset
+	std::vector<block_t, Spill_allocator<block_t>> words;
+	state_t states;
+	state_t count;
+
+	std::size_t blocks() const { return (states + bitset_t::bits_per_block - 1) / bitset_t::bits_per_block; };
+	// the most elements kept in the array, none when the bitset is a single
+	// block, that the array cannot beat
+	std::size_t sparse_max() const { return (1 < blocks()) ? blocks() : 0; };
+	bool dense() const { return sparse_max() < count; };
+	void to_dense();
+	void to_sparse();
+	// one more than the greatest element less than q, 0 if there is none
+	state_t before(const state_t q) const;
+	// the cases of set, operator|= and operator< with an array
+	void insert(const state_t);
+	void unite(const State_set &);
+	static bool less(const State_set &, const State_set &);
+
+public:
+	explicit State_set(const state_t n) : states{n}, count{0} {};
+
+	bool none() const { return 0 == count; };
+	state_t size() const { return count; };
+
+	bool test(const state_t q) const
+	{
+		if (dense()) {
+			return 0 != ((words[q / bitset_t::bits_per_block] >> (q % bitset_t::bits_per_block)) & 1);
+		}
+		return std::binary_search(words.cbegin(), words.cend(), block_t{q});
+	};
+
+	void set(const state_t q)
+	{
+		if (!dense()) {
+			insert(q);
+			return;
+		}
+		const block_t bit = block_t{1} << (q % bitset_t::bits_per_block);
+		if (0 == (words[q / bitset_t::bits_per_block] & bit)) {
+			words[q / bitset_t::bits_per_block] |= bit;
+			count++;
+		}
+	};
+
+	void reset(const state_t);
+	// the images through g of the elements of s
+	void assign_image(const State_set &s, const std::vector<state_t> &g);
+	bool intersects(const bitset_t &) const;
+
+	State_set &operator|=(const State_set &rhs)
+	{
+		if (!dense() || !rhs.dense()) {
+			unite(rhs);
+			return *this;
+		}
+		count = 0;
+		for (std::size_t i = 0; i < words.size(); i++) {
+			words[i] |= rhs.words[i];
+			count += __builtin_popcountl(words[i]);
+		}
+		return *this;
+	};
+
+	// the bytes it takes besides the object
+	std::size_t bytes() const { return words.capacity() * sizeof(block_t); };
+
+	// calls f on the elements in increasing order
+	template <typename F>
+	void for_each(F f) const
+	{
+		if (!dense()) {
+			for (auto w = words.cbegin(); w != words.cend(); w++) {
+				f(static_cast<state_t>(*w));
+			}
+			return;
+		}
+		for (std::size_t i = 0; i < words.size(); i++) {
+			for (block_t b = words[i]; 0 != b; b &= b - 1) {
+				f(static_cast<state_t>(i * bitset_t::bits_per_block + __builtin_ctzl(b)));
+			}
+		}
+	}
+
+	// the sets of the same automaton are ordered as the numbers of their
+	// bitsets, as the bitsets themselves
+	friend bool operator==(const State_set &lhs, const State_set &rhs)
+	{
+		return lhs.count == rhs.count && lhs.words == rhs.words;
+	};
+
+	friend bool operator<(const State_set &lhs, const State_set &rhs)
+	{
+		if (!lhs.dense() || !rhs.dense()) {
+			return less(lhs, rhs);
+		}
+		for (std::size_t i = lhs.words.size(); 0 < i--;) {
+			if (lhs.words[i] != rhs.words[i]) {
+				return lhs.words[i] < rhs.words[i];
+			}
+		}
+		return false;
+	};
+};
+
+#endif
@@ -0,0 +1,422 @@
+#include <algorithm>
+#include <functional>
+
+#include "rabin_automaton.h"
+
+namespace
+{
+// ordered partition of the vertices of a graph, whose cells are the ranges
+// of elems starting at the positions in cell and ending at those in end
+struct Partition final
+{
+	std::vector<std::size_t> elems;
+	std::vector<std::size_t> pos;
+	std::vector<std::size_t> cell;
+	std::vector<std::size_t> end;
+	// the first positions of the cells still to split the others by
+	std::vector<std::size_t> queue;
+	std::vector<bool> queued;
+
+	std::size_t size(const std::size_t v) const { return end[cell[v]] - cell[v]; };
+	void move(const std::size_t v, const std::size_t i)
+	{
+		const std::size_t u = elems[i];
+		elems[pos[v]] = u;
+		pos[u] = pos[v];
+		elems[i] = v;
+		pos[v] = i;
+	};
+	void push(const std::size_t c)
+	{
+		if (!queued[c]) {
+			queued[c] = true;
+			queue.push_back(c);
+		}
+	};
+	// moves x and y, of the same cell, to a cell of their own
+	void individualize(const std::size_t x, const std::size_t y)
+	{
+		const std::size_t c = cell[x];
+		const std::size_t e = end[c];
+		move(x, e - 2);
+		move(y, e - 1);
+		cell[x] = cell[y] = e - 2;
+		end[c] = e - 2;
+		end[e - 2] = e;
+		push(e - 2);
+	};
+};
+
+// color refinement of the disjoint union of two copies of the automaton, so
+// that the colors of the two have equal meaning: a vertex for each state,
+// transition and acceptance condition of each copy, and edges of several
+// kinds from every transition to its states and from every acceptance
+// condition to the states of its sets; following Hopcroft, a refinement
+// takes about (V + E) log V steps
+struct Refiner final
+{
+	// the kinds of edges, each followed by the reverse one
+	enum Edge_kind { EDGE_SOURCE, EDGE_LEFT = 2, EDGE_RIGHT = 4, EDGE_L = 6, EDGE_U = 8, EDGE_KINDS = 10 };
+
+	// the vertices of a copy and the first vertices of its transitions and
+	// acceptance conditions
+	std::size_t copy;
+	std::size_t first_transition;
+	std::size_t first_condition;
+	// the sources of the edges of each kind to every vertex v are
+	// src[k][first[k][v]], ..., src[k][first[k][v + 1] - 1]
+	std::vector<std::size_t> first[EDGE_KINDS];
+	std::vector<std::size_t> src[EDGE_KINDS];
+	// the steps taken, to bound the search of the automorphisms
+	std::size_t work;
+
+private:
+	std::vector<std::pair<std::size_t, std::size_t>> edges[EDGE_KINDS];
+	std::vector<std::size_t> count;
+	std::vector<std::size_t> touched;
+	std::vector<std::size_t> splitter;
+
+public:
+	Refiner(const std::size_t states, const std::size_t transitions, const std::size_t conditions)
+		: copy{states + transitions + conditions}
+		, first_transition{states}
+		, first_condition{states + transitions}
+		, work{0}
+		, count(2 * copy, 0) {};
+
+	void add_edge(const Edge_kind k, const std::size_t from, const std::size_t to)
+	{
+		edges[k].emplace_back(from, to);
+		edges[k + 1].emplace_back(to, from);
+	};
+
+	// lays out the edges of the first copy for both copies
+	void close()
+	{
+		for (int k = 0; k < EDGE_KINDS; k++) {
+			first[k].assign(2 * copy + 1, 0);
+			for (auto e = edges[k].cbegin(); e != edges[k].cend(); e++) {
+				first[k][e->second + 1]++;
+				first[k][e->second + copy + 1]++;
+			}
+			for (std::size_t v = 0; v < 2 * copy; v++) {
+				first[k][v + 1] += first[k][v];
+			}
+			src[k].resize(first[k].back());
+			std::vector<std::size_t> next(first[k].cbegin(), first[k].cend() - 1);
+			for (auto e = edges[k].cbegin(); e != edges[k].cend(); e++) {
+				src[k][next[e->second]++] = e->first;
+				src[k][next[e->second + copy]++] = e->first + copy;
+			}
+			edges[k].clear();
+			edges[k].shrink_to_fit();
+		}
+	};
+
+	// the cells of the states, the transitions and the acceptance conditions
+	Partition partition() const
+	{
+		Partition res;
+		res.elems.resize(2 * copy);
+		res.pos.resize(2 * copy);
+		res.cell.resize(2 * copy);
+		res.end.resize(2 * copy);
+		res.queued.assign(2 * copy, false);
+		const std::size_t bounds[] = {0, first_transition, first_condition, copy};
+		std::size_t i = 0;
+		for (int b = 0; b < 3; b++) {
+			const std::size_t c = i;
+			for (std::size_t k = 0; k < 2; k++) {
+				for (std::size_t v = bounds[b] + k * copy; v < bounds[b + 1] + k * copy; v++, i++) {
+					res.elems[i] = v;
+					res.pos[v] = i;
+					res.cell[v] = c;
+				}
+			}
+			if (c < i) {
+				res.end[c] = i;
+				res.push(c);
+			}
+		}
+		return res;
+	};
+
+	// returns false if some cell stops having as many vertices of each copy
+	bool refine(Partition &p)
+	{
+		while (!p.queue.empty()) {
+			const std::size_t s = p.queue.back();
+			p.queue.pop_back();
+			p.queued[s] = false;
+			splitter.assign(p.elems.cbegin() + s, p.elems.cbegin() + p.end[s]);
+			for (int k = 0; k < EDGE_KINDS; k++) {
+				for (auto w = splitter.cbegin(); w != splitter.cend(); w++) {
+					for (std::size_t i = first[k][*w]; i < first[k][*w + 1]; i++, work++) {
+						if (0 == count[src[k][i]]++) {
+							touched.push_back(src[k][i]);
+						}
+					}
+				}
+				work += splitter.size();
+				split(p);
+			}
+		}
+		work += p.elems.size();
+		for (std::size_t c = 0; c < p.elems.size(); c = p.end[c]) {
+			std::size_t first_copy = 0;
+			for (std::size_t i = c; i < p.end[c]; i++) {
+				first_copy += (p.elems[i] < copy) ? 1 : 0;
+			}
+			if (2 * first_copy != p.end[c] - c) {
+				return false;
+			}
+		}
+		return true;
+	};
+
+private:
+	// splits the cells of the touched vertices by their count, moving them
+	// to the end of their cell in order of count
+	void split(Partition &p)
+	{
+		std::sort(touched.begin(), touched.end(), [this, &p](const std::size_t x, const std::size_t y) {
+			return p.cell[x] < p.cell[y] || (p.cell[x] == p.cell[y] && count[x] < count[y]);
+		});
+		for (std::size_t i = 0, j = 0; i < touched.size(); i = j) {
+			const std::size_t c = p.cell[touched[i]];
+			const std::size_t e = p.end[c];
+			for (j = i; j < touched.size() && p.cell[touched[j]] == c; j++) {
+			}
+			const std::size_t m = j - i;
+			if (m == e - c && count[touched[i]] == count[touched[j - 1]]) {
+				continue;
+			}
+			for (std::size_t t = i; t < j; t++) {
+				p.move(touched[t], e - m + t - i);
+			}
+			// the untouched vertices, or else the first group, keep the cell
+			const bool was_queued = p.queued[c];
+			p.end[c] = e - m;
+			for (std::size_t t = i, x = e - m; t < j; x = p.end[x]) {
+				const std::size_t u = t;
+				for (; t < j && count[touched[t]] == count[touched[u]]; t++) {
+					if (x != c) {
+						p.cell[touched[t]] = x;
+					}
+				}
+				p.end[x] = x + t - u;
+			}
+			// a cell already split by is split by again only through all its
+			// parts but the largest, the split by it holding for the rest
+			std::size_t largest = c;
+			for (std::size_t x = c; x < e; x = p.end[x]) {
+				if (p.end[largest] - largest < p.end[x] - x) {
+					largest = x;
+				}
+			}
+			for (std::size_t x = c; x < e; x = p.end[x]) {
+				if (was_queued || x != largest) {
+					p.push(x);
+				}
+			}
+		}
+		for (auto v = touched.cbegin(); v != touched.cend(); v++) {
+			count[*v] = 0;
+		}
+		touched.clear();
+	};
+};
+} // namespace
+
+std::vector<state_t>
+State_orbits::mapping(const state_t p, const state_t q) const
+{
+	std::vector<state_t> res(states);
+	for (state_t s = 0; s < states; s++) {
+		const state_t r = from[p].empty() ? s : from[p][s];
+		res[s] = to[q].empty() ? r : to[q][r];
+	}
+	return res;
+}
+
+void
+State_orbits::add(const state_t r, const state_t q, std::vector<state_t> &&g)
+{
+	rep[q] = r;
+	from[q].resize(states);
+	for (state_t s = 0; s < states; s++) {
+		from[q][g[s]] = s;
+	}
+	to[q] = std::move(g);
+}
+
+void
+State_orbits::close()
+{
+	for (state_t q = 0; q < states; q++) {
+		members[rep[q]].push_back(q);
+		if (is_rep(q)) {
+			reps.push_back(q);
+		}
+	}
+}
+
+bool
+Rabin_automaton::is_automorphism(const std::vector<state_t> &g) const
+{
+	std::vector<std::pair<state_t, state_t>> t1;
+	std::vector<std::pair<state_t, state_t>> t2;
+	for (state_t q = 0; q < states; q++) {
+		t1.clear();
+		t2.clear();
+		for (auto t = transitions[q].cbegin(); t != transitions[q].cend(); t++) {
+			t1.emplace_back(g[t->left], g[t->right]);
+		}
+		for (auto t = transitions[g[q]].cbegin(); t != transitions[g[q]].cend(); t++) {
+			t2.emplace_back(t->left, t->right);
+		}
+		std::sort(t1.begin(), t1.end());
+		std::sort(t2.begin(), t2.end());
+		if (t1 != t2) {
+			return false;
+		}
+	}
+	std::vector<std::pair<bitset_t, bitset_t>> c1;
+	std::vector<std::pair<bitset_t, bitset_t>> c2;
+	for (auto a = conditions.cbegin(); a != conditions.cend(); a++) {
+		c1.emplace_back(a->l, a->u);
+		c2.emplace_back(bitset_t(states), bitset_t(states));
+		for (state_t q = 0; q < states; q++) {
+			c2.back().first[g[q]] = a->l[q];
+			c2.back().second[g[q]] = a->u[q];
+		}
+	}
+	std::sort(c1.begin(), c1.end());
+	std::sort(c2.begin(), c2.end());
+	return c1 == c2;
+}
+
+// color refinement followed by an individualization search of an
+// automorphism mapping each state to the others of its color, whose orbits
+// are closed under all the automorphisms found; the search is bounded by a
+// number of refinement steps linear in the size of the automaton, and the
+// states whose search fails or exceeds it are left out of the orbit
+State_orbits
+Rabin_automaton::find_orbits() const
+{
+	State_orbits res(states);
+	if (symmetry_bound < states) {
+		res.close();
+		return res;
+	}
+	std::size_t transition_num = 0;
+	for (state_t q = 0; q < states; q++) {
+		transition_num += transitions[q].size();
+	}
+	Refiner rf(states, transition_num, conditions.size());
+	std::size_t edges = 0;
+	{
+		std::size_t t = rf.first_transition;
+		for (state_t q = 0; q < states; q++) {
+			for (auto x = transitions[q].cbegin(); x != transitions[q].cend(); x++, t++) {
+				rf.add_edge(Refiner::EDGE_SOURCE, t, q);
+				rf.add_edge(Refiner::EDGE_LEFT, t, x->left);
+				rf.add_edge(Refiner::EDGE_RIGHT, t, x->right);
+				edges += 3;
+			}
+		}
+		std::size_t c = rf.first_condition;
+		for (auto a = conditions.cbegin(); a != conditions.cend(); a++, c++) {
+			for (state_t q = 0; q < states; q++) {
+				if (a->l.test(q)) {
+					rf.add_edge(Refiner::EDGE_L, c, q);
+					edges++;
+				}
+				if (a->u.test(q)) {
+					rf.add_edge(Refiner::EDGE_U, c, q);
+					edges++;
+				}
+			}
+		}
+	}
+	rf.close();
+	Partition base = rf.partition();
+	rf.refine(base);
+	const std::size_t budget = rf.work + 64 * (2 * rf.copy + 2 * edges);
+	std::vector<state_t> g(states);
+	const std::function<bool(Partition &)> search = [&](Partition &p) -> bool {
+		if (budget < rf.work || !rf.refine(p)) {
+			return false;
+		}
+		state_t x = 0;
+		while (x < states && 2 == p.size(x)) {
+			x++;
+		}
+		if (states == x) {
+			for (state_t q = 0; q < states; q++) {
+				const std::size_t c = p.cell[q];
+				g[q] = p.elems[(p.elems[c] == q) ? c + 1 : c] - rf.copy;
+			}
+			return is_automorphism(g);
+		}
+		for (std::size_t i = p.cell[x]; i < p.end[p.cell[x]]; i++) {
+			const std::size_t y = p.elems[i];
+			if (y < rf.copy) {
+				continue;
+			}
+			rf.work += p.elems.size();
+			Partition next(p);
+			next.individualize(x, y);
+			if (search(next)) {
+				return true;
+			}
+		}
+		return false;
+	};
+	std::vector<std::vector<state_t>> generators;
+	std::vector<state_t> members;
+	std::vector<bool> assigned(states, false);
+	// the images of the states already placed in the orbit join it
+	const auto close_orbit = [&](const state_t r) {
+		for (std::size_t i = 0; i < members.size(); i++) {
+			const state_t x = members[i];
+			for (auto h = generators.cbegin(); h != generators.cend(); h++) {
+				const state_t y = (*h)[x];
+				if (assigned[y]) {
+					continue;
+				}
+				std::vector<state_t> to(*h);
+				if (!res.to[x].empty()) {
+					for (state_t s = 0; s < states; s++) {
+						to[s] = (*h)[res.to[x][s]];
+					}
+				}
+				res.add(r, y, std::move(to));
+				assigned[y] = true;
+				members.push_back(y);
+			}
+		}
+	};
+	for (state_t r = 0; r < states; r++) {
+		if (assigned[r]) {
+			continue;
+		}
+		assigned[r] = true;
+		members.assign(1, r);
+		close_orbit(r);
+		for (state_t q = r + 1; q < states && rf.work <= budget; q++) {
+			if (assigned[q] || base.cell[q] != base.cell[r]) {
+				continue;
+			}
+			rf.work += base.elems.size();
+			Partition p(base);
+			p.individualize(r, q + rf.copy);
+			if (search(p)) {
+				generators.push_back(g);
+				close_orbit(r);
+			}
+		}
+	}
+	res.close();
+	return res;
+}
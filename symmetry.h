@@ -0,0 +1,40 @@
+#ifndef SYMMETRY_H
+#define SYMMETRY_H
+
+#include <vector>
+
+#include "typedefs.h"
+
+// the default number of states beyond which the automorphisms of an
+// automaton are not searched, the orbits keeping a permutation per state
+constexpr state_t SYMMETRY_BOUND = 2048;
+
+// partition of the states in orbits of (a subgroup of) the automorphisms of
+// an automaton, every state q is reached from the representative of its
+// orbit by the automorphism to[q] (empty, meaning the identity, for the
+// representatives)
+class State_orbits final
+{
+public:
+	const state_t states;
+	std::vector<state_t> rep;
+	std::vector<std::vector<state_t>> to;
+	std::vector<std::vector<state_t>> from;
+	std::vector<std::vector<state_t>> members;
+	std::vector<state_t> reps;
+
+	State_orbits(const state_t n) : states{n}, rep(n), to(n), from(n), members(n)
+	{
+		for (state_t q = 0; q < n; q++) {
+			rep[q] = q;
+		}
+	};
+
+	bool is_rep(const state_t q) const { return rep[q] == q; };
+	// automorphism mapping p to q, that must be in the same orbit
+	std::vector<state_t> mapping(const state_t, const state_t) const;
+	void add(const state_t, const state_t, std::vector<state_t> &&);
+	void close();
+};
+
+#endif
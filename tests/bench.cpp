@@ -0,0 +1,188 @@
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <unistd.h>
+#include <vector>
+
+#include "Parser.h"
+#include "version.h"
+
+using namespace RabinParser;
+using namespace std;
+
+extern int optind;
+extern char *optarg;
+
+enum Bench_metric { METRIC_PARSE, METRIC_FIND, METRIC_PRINT, METRIC_PHASES };
+constexpr int METRICS = METRIC_PHASES + PHASES;
+
+struct Bench_config
+{
+	int reps;
+	int warmup;
+	int max_threads;
+	const char *out;
+	bool version;
+};
+
+static struct Bench_config config = {10, 2, 1, nullptr, false};
+
+static Rabin_automaton *parse(const char *);
+static double seconds(const search_clock::duration);
+static double percentile(vector<double> &, const int);
+static const char *metric_name(const int);
+
+int
+main(int argc, char *argv[])
+{
+	for (int i = 0; i < argc; i++) {
+		if (nullptr == argv[i]) {
+			return EXIT_FAILURE;
+		}
+	}
+	{
+		int op = 0;
+		while ((op = getopt(argc, argv, "r:w:t:o:V")) != -1) {
+			int *dest = nullptr;
+			switch (op) {
+				case 'r':
+					dest = &config.reps;
+					break;
+				case 'w':
+					dest = &config.warmup;
+					break;
+				case 't':
+					dest = &config.max_threads;
+					break;
+				case 'o':
+					config.out = optarg;
+					break;
+				case 'V':
+					config.version = true;
+					break;
+				default:
+					return EXIT_FAILURE;
+			}
+			if (nullptr != dest) {
+				errno = 0;
+				unsigned long tmp = strtoul(optarg, nullptr, 10);
+				if (errno || INT_MAX < tmp || ('w' != op && 1 > tmp)) {
+					return EXIT_FAILURE;
+				}
+				*dest = static_cast<int>(tmp);
+			}
+		}
+	}
+	if (config.version) {
+		cout << "bench " VERSION << endl << license;
+		return EXIT_SUCCESS;
+	}
+	ofstream file;
+	if (nullptr != config.out) {
+		file.open(config.out);
+		if (!file) {
+			cerr << "could not open file " << config.out << endl;
+			return EXIT_FAILURE;
+		}
+	}
+	ostream &os = (nullptr != config.out) ? file : cout;
+	os << "{\n  \"threads\": " << config.max_threads << ",\n  \"repetitions\": " << config.reps
+	   << ",\n  \"benchmarks\": [";
+	for (int i = optind; i < argc; i++) {
+		vector<double> samples[METRICS];
+		bool nonempty = false;
+		for (int r = 0; r < config.warmup + config.reps; r++) {
+			Search_stats stats;
+			ostringstream sink;
+			search_clock::time_point t0 = search_clock::now();
+			const Rabin_automaton *const automaton = parse(argv[i]);
+			search_clock::time_point t1 = search_clock::now();
+			if (nullptr == automaton) {
+				cerr << "could not parse " << argv[i] << endl;
+				return EXIT_FAILURE;
+			}
+			const Run *const run = automaton->find_run(config.max_threads, &stats);
+			search_clock::time_point t2 = search_clock::now();
+			if (nullptr != run) {
+				sink << *run << endl;
+				run->print_logic_prog_rep(sink);
+			}
+			search_clock::time_point t3 = search_clock::now();
+			nonempty = nullptr != run;
+			delete run;
+			delete automaton;
+			if (r < config.warmup) {
+				continue;
+			}
+			samples[METRIC_PARSE].push_back(seconds(t1 - t0));
+			samples[METRIC_FIND].push_back(seconds(t2 - t1));
+			samples[METRIC_PRINT].push_back(seconds(t3 - t2));
+			for (int p = 0; p < PHASES; p++) {
+				samples[METRIC_PHASES + p].push_back(seconds(stats.phase_time[p]));
+			}
+		}
+		os << ((optind == i) ? "\n" : ",\n") << "    {\n      \"name\": \"" << argv[i] << "\",\n      \"nonempty\": "
+		   << (nonempty ? "true" : "false");
+		for (int m = 0; m < METRICS; m++) {
+			os << ",\n      \"" << metric_name(m) << "\": {\"median\": " << percentile(samples[m], 50)
+			   << ", \"p95\": " << percentile(samples[m], 95) << '}';
+		}
+		os << "\n    }";
+	}
+	os << "\n  ]\n}" << endl;
+	return EXIT_SUCCESS;
+}
+
+static Rabin_automaton *
+parse(const char *path)
+{
+	wchar_t *fileName = coco_string_create(path);
+	Scanner *const scanner = new Scanner(fileName);
+	coco_string_delete(fileName);
+	Parser *const parser = new Parser(scanner);
+	try {
+		parser->Parse();
+	} catch (const Illegal_state_set &e) {
+	}
+	Rabin_automaton *const res = parser->automaton;
+	delete parser;
+	delete scanner;
+	return res;
+}
+
+static double
+seconds(const search_clock::duration d)
+{
+	return std::chrono::duration_cast<std::chrono::duration<double>>(d).count();
+}
+
+// nearest-rank percentile
+static double
+percentile(vector<double> &samples, const int p)
+{
+	if (samples.empty()) {
+		return 0;
+	}
+	sort(samples.begin(), samples.end());
+	size_t rank = (samples.size() * p + 99) / 100;
+	return samples[(0 < rank) ? rank - 1 : 0];
+}
+
+static const char *
+metric_name(const int m)
+{
+	switch (m) {
+		case METRIC_PARSE:
+			return "parse";
+		case METRIC_FIND:
+			return "find_run";
+		case METRIC_PRINT:
+			return "print";
+		default:
+			return phase_name[m - METRIC_PHASES];
+	}
+}
@@ -0,0 +1,49 @@
+#!/usr/bin/python3
+
+import json
+import sys
+
+# usage: bench_compare.py baseline.json current.json [threshold percentage]
+# exits with status 1 if the median of some metric of some benchmark is worse
+# than the baseline by more than the threshold (and by more than MIN_DELTA
+# seconds, so that timer noise on very fast phases is not reported); the
+# metrics missing from the baseline are not compared
+
+MIN_DELTA = 0.001
+
+def load(path):
+    with open(path) as f:
+        return {b["name"]: b for b in json.load(f)["benchmarks"]}
+
+baseline = load(sys.argv[1])
+current = load(sys.argv[2])
+threshold = 10.0
+if len(sys.argv) > 3:
+    threshold = float(sys.argv[3])
+
+regressions = 0
+for name in sorted(current.keys()):
+    if not name in baseline:
+        print("{}: no baseline".format(name))
+        continue
+    b = baseline[name]
+    c = current[name]
+    if b["nonempty"] != c["nonempty"]:
+        print("{}: verdict changed".format(name))
+        regressions += 1
+    for metric in sorted(c.keys()):
+        if not isinstance(c[metric], dict) or not metric in b:
+            continue
+        old = b[metric]["median"]
+        new = c[metric]["median"]
+        change = 0.0
+        if old > 0:
+            change = 100.0 * (new - old) / old
+        status = "ok"
+        if new - old > MIN_DELTA and change > threshold:
+            status = "REGRESSION"
+            regressions += 1
+        print("{} {}: {:.6f} -> {:.6f} ({:+.1f}%) {}".format(name, metric, old, new, change, status))
+
+print("{} regression(s) over the {}% threshold".format(regressions, threshold))
+sys.exit(1 if regressions > 0 else 0)
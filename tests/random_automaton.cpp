@@ -1,5 +1,6 @@
 #include <cerrno>
 #include <cstdlib>
+#include <cstring>
 #include <iostream>
 #include <random>
 #include <unistd.h>
@@ -12,7 +13,16 @@ using namespace std;
 extern int optind;
 extern char *optarg;
 
+static constexpr const char *family_name[] = {"random", "chain", "counter", "parity", "empty"};
+
 static state_t rand_state();
+static state_t rand_below(const state_t);
+static void rand_set(bitset_t &, const state_t, const state_t, const runid_t);
+static void random_family(Rabin_automaton &);
+static void chain_family(Rabin_automaton &);
+static void counter_family(Rabin_automaton &);
+static void parity_family(Rabin_automaton &);
+static void empty_family(Rabin_automaton &);
 
 int
 main(int argc, char *argv[])
@@ -24,9 +34,20 @@ main(int argc, char *argv[])
 	}
 	{
 		int op = 0;
-		while ((op = getopt(argc, argv, "s:t:a:e:r:V")) != -1) {
+		while ((op = getopt(argc, argv, "f:s:t:a:e:r:V")) != -1) {
 			runid_t *dest = nullptr;
 			switch (op) {
+				case 'f': {
+					int f = FAMILY_RANDOM;
+					while (f <= FAMILY_EMPTY && 0 != strcmp(optarg, family_name[f])) {
+						f++;
+					}
+					if (FAMILY_EMPTY < f) {
+						return EXIT_FAILURE;
+					}
+					config.family = static_cast<Family>(f);
+					break;
+				}
 				case 's':
 					dest = &config.states_dest;
 					break;
@@ -49,7 +70,7 @@ main(int argc, char *argv[])
 				default:
 					return EXIT_FAILURE;
 			}
-			if ('V' != op) {
+			if ('V' != op && 'f' != op) {
 				errno = 0;
 				unsigned long long tmp = strtoull(optarg, NULL, 10);
 				if (errno || RUNID_MAX < tmp) {
@@ -73,42 +94,198 @@ main(int argc, char *argv[])
 		return EXIT_FAILURE;
 	}
 	Rabin_automaton automaton(config.states);
+	switch (config.family) {
+		case FAMILY_CHAIN:
+			chain_family(automaton);
+			break;
+		case FAMILY_COUNTER:
+			counter_family(automaton);
+			break;
+		case FAMILY_PARITY:
+			parity_family(automaton);
+			break;
+		case FAMILY_EMPTY:
+			empty_family(automaton);
+			break;
+		default:
+			random_family(automaton);
+	}
+	cout << automaton << endl;
+	return EXIT_SUCCESS;
+}
+
+// uniformly random transitions and acceptance conditions
+static void
+random_family(Rabin_automaton &automaton)
+{
 	for (runid_t i = 0; i < config.transitions; i++) {
 		automaton.add_transition(rand_state(), rand_state(), rand_state());
 	}
-
-	const auto rand_set = [](bitset_t &set) {
-		runid_t card = 0;
-		while (card < config.acc_elements && card < config.states) {
-			state_t q = rand_state();
-			if (!set.test_set(q)) {
-				card++;
-			}
-		}
-	};
-
 	bitset_t l(config.states);
 	bitset_t u(config.states);
 	for (runid_t i = 0; i < config.acceptances; i++) {
-		rand_set(l);
-		rand_set(u);
+		rand_set(l, 0, config.states, config.acc_elements);
+		rand_set(u, 0, config.states, config.acc_elements);
 		automaton.add_acceptance(l, u);
 		l.reset();
 		u.reset();
 	}
-	cout << automaton << endl;
-	return EXIT_SUCCESS;
+}
+
+// a cycle 0 > 1 1, ..., n-1 > 0 0 with random forward shortcuts, every path
+// of which is accepted only by passing through n - 1, plus random acceptance
+// conditions
+static void
+chain_family(Rabin_automaton &automaton)
+{
+	const state_t n = config.states;
+	for (state_t q = 0; q + 1 < n; q++) {
+		automaton.add_transition(q, q + 1, q + 1);
+	}
+	automaton.add_transition(n - 1, 0, 0);
+	for (runid_t i = 0; i < config.transitions && 2 < n; i++) {
+		const state_t q = rand_below(n - 2);
+		automaton.add_transition(q, q + 1 + rand_below(n - q - 1), q + 1 + rand_below(n - q - 1));
+	}
+	bitset_t l(n);
+	bitset_t u(n);
+	u.set(n - 1);
+	automaton.add_acceptance(l, u);
+	for (runid_t i = 0; i < config.acceptances; i++) {
+		l.reset();
+		u.reset();
+		rand_set(l, 0, n, config.acc_elements);
+		rand_set(u, 0, n, config.acc_elements);
+		automaton.add_acceptance(l, u);
+	}
+}
+
+// every state is a bit of a binary counter: bit i carries into two copies of
+// bit i - 1 (or into random lower bits) and bit 0 overflows into the highest
+// bit, a path is accepted if the highest bit it sees infinitely often is even,
+// so the language is nonempty if and only if the number of states is odd (-a
+// and -e are ignored)
+static void
+counter_family(Rabin_automaton &automaton)
+{
+	const state_t n = config.states;
+	for (state_t q = 1; q < n; q++) {
+		automaton.add_transition(q, q - 1, q - 1);
+	}
+	automaton.add_transition(0, n - 1, n - 1);
+	for (runid_t i = 0; i < config.transitions && 1 < n; i++) {
+		const state_t q = 1 + rand_below(n - 1);
+		automaton.add_transition(q, rand_below(q), rand_below(q));
+	}
+	bitset_t l(n);
+	bitset_t u(n);
+	for (state_t q = 0; q < n; q += 2) {
+		l.reset();
+		u.reset();
+		for (state_t b = q + 1; b < n; b++) {
+			l.set(b);
+		}
+		u.set(q);
+		automaton.add_acceptance(l, u);
+	}
+}
+
+// random transitions and a chain of -a nested acceptance conditions induced
+// by a random priority (from 1 to 2a + 1) of every state: the i-th condition
+// forbids the priorities below 2i and requires priority 2i
+static void
+parity_family(Rabin_automaton &automaton)
+{
+	const state_t n = config.states;
+	for (runid_t i = 0; i < config.transitions; i++) {
+		automaton.add_transition(rand_state(), rand_state(), rand_state());
+	}
+	runid_t *const priority = new runid_t[n];
+	for (state_t q = 0; q < n; q++) {
+		priority[q] = 1 + rand_below(static_cast<state_t>(2 * config.acceptances + 1));
+	}
+	bitset_t l(n);
+	bitset_t u(n);
+	for (runid_t i = 1; i <= config.acceptances; i++) {
+		l.reset();
+		u.reset();
+		for (state_t q = 0; q < n; q++) {
+			if (priority[q] < 2 * i) {
+				l.set(q);
+			} else if (priority[q] == 2 * i) {
+				u.set(q);
+			}
+		}
+		automaton.add_acceptance(l, u);
+	}
+	delete[] priority;
+}
+
+// the lower half of the states only has transitions towards higher states of
+// the same half or back to the starting state 0, which is forbidden by every
+// acceptance condition, so the language is empty; the upper half is an
+// independent random component whose nonempty states keep invalidating
+// pieces during the whole search
+static void
+empty_family(Rabin_automaton &automaton)
+{
+	const state_t n = config.states;
+	const state_t k = (1 < n) ? n / 2 : 1;
+	const auto lower_child = [k](const state_t q) -> state_t {
+		return (q + 1 < k && rand_below(2)) ? q + 1 + rand_below(k - q - 1) : 0;
+	};
+	for (state_t q = 0; q < k; q++) {
+		automaton.add_transition(q, (q + 1 < k) ? q + 1 : 0, (q + 1 < k) ? q + 1 : 0);
+	}
+	for (state_t q = k; q < n; q++) {
+		automaton.add_transition(q, k + rand_below(n - k), k + rand_below(n - k));
+	}
+	for (runid_t i = 0; i < config.transitions; i++) {
+		if (k == n || rand_below(2)) {
+			const state_t q = rand_below(k);
+			automaton.add_transition(q, lower_child(q), lower_child(q));
+		} else {
+			automaton.add_transition(k + rand_below(n - k), k + rand_below(n - k), k + rand_below(n - k));
+		}
+	}
+	bitset_t l(n);
+	bitset_t u(n);
+	for (runid_t i = 0; i < config.acceptances && 1 < n; i++) {
+		l.reset();
+		u.reset();
+		l.set(0);
+		rand_set(u, 1, n, config.acc_elements);
+		automaton.add_acceptance(l, u);
+	}
+}
+
+// sets card random states of [from, to) in set
+static void
+rand_set(bitset_t &set, const state_t from, const state_t to, const runid_t card)
+{
+	runid_t c = 0;
+	while (c < card && c < to - from) {
+		if (!set.test_set(from + rand_below(to - from))) {
+			c++;
+		}
+	}
 }
 
 static state_t
 rand_state()
+{
+	return rand_below(config.states);
+}
+
+static state_t
+rand_below(const state_t n)
 {
 	static mt19937 engine(
 		config.use_seed ? (mt19937::result_type)config.seed : (mt19937::result_type)random_device()());
-	static const mt19937::result_type limit = mt19937::max() - mt19937::max() % config.states;
+	const mt19937::result_type limit = mt19937::max() - mt19937::max() % n;
 	mt19937::result_type s = engine();
 	while (limit < s) {
 		s = engine();
 	}
-	return (state_t)(s % config.states);
+	return (state_t)(s % n);
 }
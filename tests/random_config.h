@@ -3,8 +3,11 @@
 
 #include "rabin_automaton.h"
 
+enum Family { FAMILY_RANDOM, FAMILY_CHAIN, FAMILY_COUNTER, FAMILY_PARITY, FAMILY_EMPTY };
+
 struct Random_config
 {
+	Family family;
 	state_t states;
 	runid_t transitions;
 	runid_t acceptances;
@@ -15,6 +18,6 @@ struct Random_config
 	runid_t states_dest;
 };
 
-static struct Random_config config = {0, 0, 0, 0, 0, false, false, 0};
+static struct Random_config config = {FAMILY_RANDOM, 0, 0, 0, 0, 0, false, false, 0};
 
 #endif
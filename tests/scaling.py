@@ -0,0 +1,49 @@
+#!/usr/bin/python3
+
+import json
+import math
+import matplotlib.pyplot as plt
+import sys
+
+# usage: scaling.py 1.json 2.json ...
+# reads the results of bench with different numbers of threads and reports for
+# every family of automata (the prefix of the file name up to the first
+# underscore) the geometric mean of the speedup of the search over the
+# single-threaded results and the parallel efficiency (speedup / threads)
+
+def family(name):
+    return name.split("/")[-1].split("_")[0]
+
+runs = {}
+for path in sys.argv[1:]:
+    with open(path) as f:
+        r = json.load(f)
+    runs[r["threads"]] = {b["name"]: b["find_run"]["median"] for b in r["benchmarks"]}
+
+if not 1 in runs:
+    sys.exit("missing single-threaded results")
+
+speedups = {}
+for t in sorted(runs.keys()):
+    logs = {}
+    for name, time in runs[t].items():
+        if name in runs[1] and time > 0 and runs[1][name] > 0:
+            logs.setdefault(family(name), []).append(math.log(runs[1][name] / time))
+    for f, l in logs.items():
+        speedups.setdefault(f, ([], []))
+        speedups[f][0].append(t)
+        speedups[f][1].append(math.exp(sum(l) / len(l)))
+
+print("{:<10} {:>7} {:>8} {:>10}".format("family", "threads", "speedup", "efficiency"))
+for f in sorted(speedups.keys()):
+    for t, s in zip(*speedups[f]):
+        print("{:<10} {:>7} {:>8.2f} {:>9.0f}%".format(f, t, s, 100.0 * s / t))
+
+plt.ylabel('speedup')
+plt.xlabel('threads')
+for f in sorted(speedups.keys()):
+    plt.plot(speedups[f][0], speedups[f][1], label=f)
+plt.plot(sorted(runs.keys()), sorted(runs.keys()), label="linear", c='grey', ls='--')
+
+plt.legend()
+plt.show()
@@ -0,0 +1,52 @@
+#include "trace.h"
+
+thread_local Trace_buffer *Trace_buffer::local = nullptr;
+
+static long long
+microseconds(const search_clock::duration d)
+{
+	return std::chrono::duration_cast<std::chrono::microseconds>(d).count();
+}
+
+Trace::~Trace()
+{
+	for (auto t = buffers.cbegin(); t != buffers.cend(); t++) {
+		delete *t;
+	}
+}
+
+Trace_buffer *
+Trace::buffer(const char *name)
+{
+	const std::lock_guard<std::mutex> l(lock);
+	buffers.push_back(new Trace_buffer(buffers.size(), name));
+	return buffers.back();
+}
+
+// Chrome trace event format, readable by chrome://tracing and Perfetto
+std::ostream &
+operator<<(std::ostream &os, const Trace &trace)
+{
+	bool first = true;
+	os << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [";
+	for (auto b = trace.buffers.cbegin(); b != trace.buffers.cend(); b++) {
+		os << (first ? "\n" : ",\n") << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": " << (*b)->tid
+		   << ", \"args\": {\"name\": \"" << (*b)->name << ' ' << (*b)->tid << "\"}}";
+		first = false;
+		for (auto e = (*b)->events.cbegin(); e != (*b)->events.cend(); e++) {
+			os << ",\n{\"name\": \"" << e->name << "\", \"cat\": \"find_run\", \"ph\": \"" << e->phase
+			   << "\", \"pid\": 1, \"tid\": " << (*b)->tid << ", \"ts\": " << microseconds(e->begin - trace.origin);
+			if ('X' == e->phase) {
+				os << ", \"dur\": " << microseconds(e->end - e->begin);
+			} else {
+				os << ", \"s\": \"t\"";
+			}
+			os << ", \"args\": {\"height\": " << e->height;
+			if (STATE_MAX != e->state) {
+				os << ", \"state\": " << e->state;
+			}
+			os << "}}";
+		}
+	}
+	return os << "\n]}";
+}
@@ -0,0 +1,97 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <mutex>
+#include <ostream>
+#include <vector>
+
+#include "search_stats.h"
+
+class Trace;
+
+struct Trace_event
+{
+	const char *name;
+	char phase;
+	search_clock::time_point begin;
+	search_clock::time_point end;
+	state_t height;
+	state_t state;
+};
+
+// events are appended only by the thread currently owning the buffer, so
+// recording needs no synchronization
+class Trace_buffer final
+{
+public:
+	const unsigned int tid;
+	const char *const name;
+	state_t height;
+
+private:
+	std::vector<Trace_event> events;
+
+public:
+	static thread_local Trace_buffer *local;
+
+	Trace_buffer(const unsigned int t, const char *n) : tid{t}, name{n}, height{0} {};
+
+	void span(const char *n, const search_clock::time_point b, const state_t h, const state_t q)
+	{
+		events.push_back({n, 'X', b, search_clock::now(), h, q});
+	};
+	void instant(const char *n, const state_t q)
+	{
+		const search_clock::time_point now = search_clock::now();
+		events.push_back({n, 'i', now, now, height, q});
+	};
+
+	friend std::ostream &operator<<(std::ostream &, const Trace &);
+};
+
+class Trace_span final
+{
+	Trace_buffer *const buffer;
+	const char *const name;
+	const state_t height;
+	const state_t state;
+	const search_clock::time_point begin;
+
+public:
+	Trace_span(Trace_buffer *const b, const char *n, const state_t h, const state_t q)
+		: buffer{b}, name{n}, height{h}, state{q}, begin{(nullptr != b) ? search_clock::now() : search_clock::time_point()}
+	{
+	}
+	Trace_span(const Trace_span &) = delete;
+	Trace_span(Trace_span &&) = delete;
+	~Trace_span()
+	{
+		if (nullptr != buffer) {
+			buffer->span(name, begin, height, state);
+		}
+	};
+	Trace_span &operator=(const Trace_span &) = delete;
+	Trace_span &operator=(Trace_span &&) = delete;
+};
+
+class Trace final
+{
+	const search_clock::time_point origin;
+	std::vector<Trace_buffer *> buffers;
+	std::mutex lock;
+
+public:
+	Trace() : origin{search_clock::now()} {};
+	Trace(const Trace &) = delete;
+	Trace(Trace &&) = delete;
+	~Trace();
+	Trace &operator=(const Trace &) = delete;
+	Trace &operator=(Trace &&) = delete;
+
+	Trace_buffer *buffer(const char *);
+
+	friend std::ostream &operator<<(std::ostream &, const Trace &);
+};
+std::ostream &operator<<(std::ostream &, const Trace &);
+
+#endif
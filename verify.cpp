@@ -0,0 +1,469 @@
+#include <algorithm>
+#include <functional>
+#include <list>
+#include <set>
+#include <stack>
+#include <unordered_map>
+#include <vector>
+
+#include "rabin_automaton.h"
+
+namespace
+{
+constexpr std::size_t NO_NODE = SIZE_MAX;
+
+// the nodes of the trees of a run, with an edge from every internal node to
+// its children, from every graft leaf to the node of its state and from
+// every other leaf back to its nearest ancestor of the same state, so that
+// the run of a state is the unfolding of the graph from the node of the state
+class Run_graph final
+{
+	const Run &run;
+	const std::vector<std::vector<std::pair<state_t, state_t>>> &moves;
+	std::unordered_map<const Run_node *, std::size_t> ids;
+	// the nearest ancestor of every state of the node being visited
+	std::vector<std::size_t> last;
+	std::vector<std::pair<std::size_t, const Run_node *>> pending;
+	std::stack<const Run_node *> trees;
+
+public:
+	std::vector<state_t> state;
+	std::vector<std::size_t> left;
+	std::vector<std::size_t> right;
+	// the nodes of the states of starts
+	std::vector<std::size_t> start;
+	bool valid;
+
+	Run_graph(
+		const Run &r,
+		const std::vector<state_t> &starts,
+		const std::vector<std::vector<std::pair<state_t, state_t>>> &m)
+		: run{r}, moves{m}, last(r.states, NO_NODE), valid{true}
+	{
+		for (auto q = starts.cbegin(); valid && q != starts.cend(); q++) {
+			valid = nullptr != run.graft(*q);
+			if (valid && ids.emplace(run.graft(*q)->root(), NO_NODE).second) {
+				trees.push(run.graft(*q)->root());
+			}
+		}
+		for (; valid && !trees.empty();) {
+			const Run_node *const t = trees.top();
+			trees.pop();
+			visit(t);
+		}
+		for (auto p = pending.cbegin(); valid && p != pending.cend(); p++) {
+			left[p->first] = right[p->first] = ids.at(p->second);
+		}
+		for (auto q = starts.cbegin(); valid && q != starts.cend(); q++) {
+			start.push_back(ids.at(run.graft(*q)));
+		}
+	};
+
+	std::size_t degree(const std::size_t) const { return 2; };
+	std::size_t next(const std::size_t x, const std::size_t i) const { return (0 == i) ? left[x] : right[x]; };
+
+private:
+	void visit(const Run_node *const n)
+	{
+		const std::size_t id = state.size();
+		ids[n] = id;
+		if (run.states <= n->state) {
+			valid = false;
+			return;
+		}
+		state.push_back(n->state);
+		left.push_back(NO_NODE);
+		right.push_back(NO_NODE);
+		if (nullptr != n->left) {
+			const std::pair<state_t, state_t> t{n->left->state, n->right->state};
+			if (!std::binary_search(moves[n->state].cbegin(), moves[n->state].cend(), t)) {
+				valid = false;
+				return;
+			}
+			const std::size_t above = last[n->state];
+			last[n->state] = id;
+			left[id] = state.size();
+			visit(n->left);
+			right[id] = state.size();
+			if (valid) {
+				visit(n->right);
+			}
+			last[n->state] = above;
+		} else if (n->graft) {
+			const Run_node *const g = run.graft(n->state);
+			if (nullptr == g || g->state != n->state || nullptr == g->left) {
+				valid = false;
+				return;
+			}
+			pending.emplace_back(id, g);
+			if (ids.emplace(g->root(), NO_NODE).second) {
+				trees.push(g->root());
+			}
+		} else if (NO_NODE == last[n->state]) {
+			valid = false;
+		} else {
+			left[id] = right[id] = last[n->state];
+		}
+	};
+};
+
+// the strongly connected components with a cycle of the subgraphs of a graph
+// of a run or of a certificate, found by an iterative Tarjan's algorithm
+template <typename Graph>
+class Cycle_components final
+{
+	const Graph &g;
+	std::vector<char> in;
+	std::vector<std::size_t> index;
+	std::vector<std::size_t> low;
+	std::vector<char> on_stack;
+	std::vector<std::size_t> component;
+	std::vector<std::pair<std::size_t, std::size_t>> calls;
+
+public:
+	Cycle_components(const Graph &graph)
+		: g{graph}
+		, in(graph.state.size(), 0)
+		, index(graph.state.size(), NO_NODE)
+		, low(graph.state.size(), 0)
+		, on_stack(graph.state.size(), 0) {};
+
+	// calls f on the members of every component of the subgraph of the nodes
+	// of part, until it returns false
+	bool each(const std::vector<std::size_t> &part, const std::function<bool(const std::vector<std::size_t> &)> &f)
+	{
+		for (auto x = part.cbegin(); x != part.cend(); x++) {
+			in[*x] = 1;
+			index[*x] = NO_NODE;
+		}
+		const bool res = visit(part, f);
+		for (auto x = part.cbegin(); x != part.cend(); x++) {
+			in[*x] = 0;
+		}
+		calls.clear();
+		component.clear();
+		return res;
+	};
+
+private:
+	bool visit(const std::vector<std::size_t> &part, const std::function<bool(const std::vector<std::size_t> &)> &f)
+	{
+		std::vector<std::size_t> members;
+		std::size_t next = 0;
+		for (auto r = part.cbegin(); r != part.cend(); r++) {
+			if (NO_NODE != index[*r]) {
+				continue;
+			}
+			calls.emplace_back(*r, 0);
+			index[*r] = low[*r] = next++;
+			component.push_back(*r);
+			on_stack[*r] = 1;
+			while (!calls.empty()) {
+				const std::size_t x = calls.back().first;
+				std::size_t &i = calls.back().second;
+				if (i < g.degree(x)) {
+					const std::size_t y = g.next(x, i++);
+					if (!in[y]) {
+						continue;
+					}
+					if (NO_NODE == index[y]) {
+						index[y] = low[y] = next++;
+						component.push_back(y);
+						on_stack[y] = 1;
+						calls.emplace_back(y, 0);
+					} else if (on_stack[y] && index[y] < low[x]) {
+						low[x] = index[y];
+					}
+					continue;
+				}
+				calls.pop_back();
+				if (!calls.empty() && low[x] < low[calls.back().first]) {
+					low[calls.back().first] = low[x];
+				}
+				if (low[x] != index[x]) {
+					continue;
+				}
+				// x is the root of a component, that has a cycle if it has more
+				// than a node or a self loop
+				bool cycle = component.back() != x;
+				for (std::size_t j = 0; !cycle && j < g.degree(x); j++) {
+					cycle = g.next(x, j) == x;
+				}
+				members.clear();
+				std::size_t y = NO_NODE;
+				do {
+					y = component.back();
+					component.pop_back();
+					on_stack[y] = 0;
+					members.push_back(y);
+				} while (y != x);
+				if (cycle && !f(members)) {
+					return false;
+				}
+			}
+		}
+		return true;
+	};
+};
+
+// whether every strongly connected set of the nodes of part that visits the l
+// of a pair also visits its u: a cycle violating the pair lies in a component
+// of the nodes outside of u that contains a node of l
+template <typename Graph>
+bool
+streett_cycles(
+	const Graph &g,
+	Cycle_components<Graph> &components,
+	const std::vector<std::size_t> &part,
+	const std::list<Acceptance> &pairs)
+{
+	for (auto a = pairs.cbegin(); a != pairs.cend(); a++) {
+		std::vector<std::size_t> outside;
+		for (auto x = part.cbegin(); x != part.cend(); x++) {
+			if (!a->u.test(g.state[*x])) {
+				outside.push_back(*x);
+			}
+		}
+		if (!components.each(outside, [&g, a](const std::vector<std::size_t> &members) {
+				return std::none_of(members.cbegin(), members.cend(), [&g, a](const std::size_t m) {
+					return a->l.test(g.state[m]);
+				});
+			})) {
+			return false;
+		}
+	}
+	return true;
+}
+
+// whether every strongly connected set of the nodes of part visits the u of
+// some pair without visiting its l: a component is visited as a whole by some
+// path, so it needs a pair it satisfies as a whole, and then only its cycles
+// avoiding the u of that pair are left to check
+template <typename Graph>
+bool
+rabin_cycles(
+	const Graph &g,
+	Cycle_components<Graph> &components,
+	std::vector<std::size_t> part,
+	const std::list<Acceptance> &pairs)
+{
+	const auto meets = [&g](const std::vector<std::size_t> &members, const bitset_t &s) {
+		return std::any_of(members.cbegin(), members.cend(), [&g, &s](const std::size_t m) {
+			return s.test(g.state[m]);
+		});
+	};
+	std::stack<std::vector<std::size_t>> parts;
+	for (parts.push(std::move(part)); !parts.empty();) {
+		const std::vector<std::size_t> nodes = std::move(parts.top());
+		parts.pop();
+		if (!components.each(nodes, [&](const std::vector<std::size_t> &members) {
+				auto a = pairs.cbegin();
+				for (; a != pairs.cend() && (!meets(members, a->u) || meets(members, a->l)); a++) {
+				}
+				if (pairs.cend() == a) {
+					return false;
+				}
+				std::vector<std::size_t> rest;
+				for (auto m = members.cbegin(); m != members.cend(); m++) {
+					if (!a->u.test(g.state[*m])) {
+						rest.push_back(*m);
+					}
+				}
+				if (!rest.empty()) {
+					parts.push(std::move(rest));
+				}
+				return true;
+			})) {
+			return false;
+		}
+	}
+	return true;
+}
+
+// the pairs (u, l) of the pairs (l, u), of the paths that the pairs reject
+// when read as Rabin pairs instead of Streett pairs or the other way round
+std::list<Acceptance>
+swapped(const std::list<Acceptance> &pairs)
+{
+	std::list<Acceptance> res;
+	for (auto a = pairs.cbegin(); a != pairs.cend(); a++) {
+		res.emplace_back(a->u, a->l);
+	}
+	return res;
+}
+} // namespace
+
+// whether run is a run of the automaton from its starting state, or with
+// all_states from each of its nonempty states, whose paths are all accepted:
+// every node follows a transition of its state and every set of nodes of the
+// graph of the run reached from those states that a path can visit
+// infinitely often, that is every strongly connected set, meets the
+// acceptance condition; each kind of condition is checked on the components
+// of some subgraphs, in time linear in the size of the run for each Rabin or
+// Streett pair and for each state of each Muller set
+bool
+Rabin_automaton::verify(const Run &run) const
+{
+	if (run.states != states || run.start != starting_state) {
+		return false;
+	}
+	std::vector<std::vector<std::pair<state_t, state_t>>> moves(states);
+	for (state_t q = 0; q < states; q++) {
+		for (auto t = transitions[q].cbegin(); t != transitions[q].cend(); t++) {
+			moves[q].emplace_back(t->left, t->right);
+		}
+		std::sort(moves[q].begin(), moves[q].end());
+	}
+	std::vector<state_t> starts(1, starting_state);
+	if (all_states) {
+		starts.clear();
+		for (state_t q = 0; q < states; q++) {
+			if (run.nonempty(q)) {
+				starts.push_back(q);
+			}
+		}
+	}
+	const Run_graph g(run, starts, moves);
+	if (!g.valid) {
+		return false;
+	}
+	std::vector<char> in(g.state.size(), 0);
+	std::vector<std::size_t> reached;
+	std::stack<std::size_t> stack;
+	for (auto x = g.start.cbegin(); x != g.start.cend(); x++) {
+		if (!in[*x]) {
+			in[*x] = 1;
+			stack.push(*x);
+		}
+	}
+	while (!stack.empty()) {
+		const std::size_t x = stack.top();
+		stack.pop();
+		reached.push_back(x);
+		for (const std::size_t y : {g.left[x], g.right[x]}) {
+			if (!in[y]) {
+				in[y] = 1;
+				stack.push(y);
+			}
+		}
+	}
+	Cycle_components<Run_graph> components(g);
+	if (ACCEPTANCE_STREETT == kind) {
+		return streett_cycles(g, components, reached, streett_pairs);
+	}
+	if (ACCEPTANCE_MULLER == kind) {
+		const auto states_of = [this, &g](const std::vector<std::size_t> &members) -> bitset_t {
+			bitset_t res(states);
+			for (auto m = members.cbegin(); m != members.cend(); m++) {
+				res.set(g.state[*m]);
+			}
+			return res;
+		};
+		const auto nodes_in = [&g, &reached](const bitset_t &s) -> std::vector<std::size_t> {
+			std::vector<std::size_t> res;
+			for (auto x = reached.cbegin(); x != reached.cend(); x++) {
+				if (s.test(g.state[*x])) {
+					res.push_back(*x);
+				}
+			}
+			return res;
+		};
+		// the states of a strongly connected set that is not a Muller set
+		// are those of a component of the nodes of a set y, starting from
+		// all the states and then removing a state from the states of the
+		// components met, that are Muller sets, until it is found
+		const std::set<bitset_t> sets(muller_sets.cbegin(), muller_sets.cend());
+		std::set<bitset_t> seen;
+		std::stack<bitset_t> ys;
+		for (ys.push(bitset_t(states).set()); !ys.empty();) {
+			const bitset_t y = std::move(ys.top());
+			ys.pop();
+			if (!components.each(nodes_in(y), [&](const std::vector<std::size_t> &members) {
+					const bitset_t z = states_of(members);
+					if (!sets.count(z)) {
+						return false;
+					}
+					for (auto q = z.find_first(); z.npos != q; q = z.find_next(q)) {
+						bitset_t smaller(z);
+						smaller.reset(q);
+						if (seen.insert(smaller).second) {
+							ys.push(std::move(smaller));
+						}
+					}
+					return true;
+				})) {
+				return false;
+			}
+		}
+		return true;
+	}
+	return rabin_cycles(g, components, std::move(reached), conditions);
+}
+
+// whether the certificate proves that the language is empty: it has a node of
+// the starting state, the entry of every node of a state q for a transition
+// of q leads to a node of one of its children, and no strongly connected set
+// of nodes, that a path can visit infinitely often, is accepted; that is
+// checked on the components of some subgraphs as for a run, reading the
+// Rabin pairs as the Streett pairs of the rejected paths and the other way
+// round, and with a component of the nodes of the states of each Muller set
+// having only some of them, in time linear in the size of the certificate
+// for each pair or Muller set
+bool
+Rabin_automaton::check_certificate(const Certificate &c) const
+{
+	bool start = false;
+	for (std::size_t x = 0; x < c.nodes(); x++) {
+		if (states <= c.state[x] || transitions[c.state[x]].size() != c.degree(x)) {
+			return false;
+		}
+		start = start || starting_state == c.state[x];
+		std::size_t i = 0;
+		for (auto t = transitions[c.state[x]].cbegin(); t != transitions[c.state[x]].cend(); t++, i++) {
+			const state_t p = c.state[c.next(x, i)];
+			if (p != t->left && p != t->right) {
+				return false;
+			}
+		}
+	}
+	if (!start) {
+		return false;
+	}
+	std::vector<std::size_t> nodes(c.nodes());
+	for (std::size_t x = 0; x < c.nodes(); x++) {
+		nodes[x] = x;
+	}
+	Cycle_components<Certificate> components(c);
+	if (ACCEPTANCE_RABIN == kind) {
+		return streett_cycles(c, components, nodes, swapped(conditions));
+	}
+	if (ACCEPTANCE_STREETT == kind) {
+		return rabin_cycles(c, components, std::move(nodes), swapped(streett_pairs));
+	}
+	// the component that last counted every state
+	std::vector<std::size_t> counted(states, 0);
+	std::size_t component = 0;
+	for (auto s = muller_sets.cbegin(); s != muller_sets.cend(); s++) {
+		const std::size_t size = s->count();
+		std::vector<std::size_t> inside;
+		for (auto x = nodes.cbegin(); x != nodes.cend(); x++) {
+			if (s->test(c.state[*x])) {
+				inside.push_back(*x);
+			}
+		}
+		if (!components.each(inside, [&](const std::vector<std::size_t> &members) {
+				std::size_t found = 0;
+				component++;
+				for (auto m = members.cbegin(); m != members.cend(); m++) {
+					if (component != counted[c.state[*m]]) {
+						counted[c.state[*m]] = component;
+						found++;
+					}
+				}
+				return found < size;
+			})) {
+			return false;
+		}
+	}
+	return true;
+}